@@ -1,11 +1,76 @@
+#ifdef MAZE_EMBEDDED
+#error "API.c is the host text protocol; embedded builds link the board's HAL (see API.h)"
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "transport.h" // opcodes; the channel code is only linked with USE_BINARY_TRANSPORT
 
 #define BUFFER_SIZE 32
 
-int getInteger(char *command)
+#ifdef USE_BINARY_TRANSPORT
+// Text protocol on stdin/stdout by default; the binary transport when the
+// simulator hands us a channel in MAZE_TRANSPORT (see transport.h).
+// Build with -DUSE_BINARY_TRANSPORT and link transport.c to enable it.
+static int transportMode = -1;
+static Channel channel;
+
+static int useBinary()
+{
+    if (transportMode < 0)
+    {
+        char *spec = getenv("MAZE_TRANSPORT");
+        if (spec && transportOpen(&channel, spec) == 0)
+            transportMode = channel.mode;
+        else
+            transportMode = TRANSPORT_TEXT;
+    }
+    return transportMode != TRANSPORT_TEXT;
+}
+
+// Nobody is left to answer: stop instead of solving on made-up replies.
+static void simulatorGone()
 {
+    fprintf(stderr, "solver: the simulator closed the channel, exiting\n");
+    exit(1);
+}
+
+static int callBinary(int opcode)
+{
+    Frame request = {0};
+    Frame reply = {0};
+    request.opcode = opcode;
+    if (transportCall(&channel, &request, &reply) != 0)
+        simulatorGone();
+    return reply.value;
+}
+
+static void sendBinary(int opcode, int x, int y, char arg, char *text)
+{
+    Frame request = {0};
+    request.opcode = opcode;
+    request.x = x;
+    request.y = y;
+    request.arg = arg;
+    if (text)
+        memcpy(request.text, text, strnlen(text, FRAME_TEXT_SIZE));
+    if (transportCall(&channel, &request, NULL) != 0)
+        simulatorGone();
+}
+#else
+// without the binary transport every call goes through the text protocol
+#define useBinary() 0
+#define callBinary(opcode) 0
+#define sendBinary(opcode, x, y, arg, text)
+#endif
+
+int getInteger(int opcode, char *command)
+{
+    (void)opcode; // only the binary transport reads it
+    if (useBinary())
+        return callBinary(opcode);
+
     printf("%s\n", command);
     fflush(stdout);
     char response[BUFFER_SIZE];
@@ -14,8 +79,12 @@ int getInteger(char *command)
     return value;
 }
 
-int getBoolean(char *command)
+int getBoolean(int opcode, char *command)
 {
+    (void)opcode; // only the binary transport reads it
+    if (useBinary())
+        return callBinary(opcode) != 0;
+
     printf("%s\n", command);
     fflush(stdout);
     char response[BUFFER_SIZE];
@@ -24,8 +93,12 @@ int getBoolean(char *command)
     return value;
 }
 
-int getAck(char *command)
+int getAck(int opcode, char *command)
 {
+    (void)opcode; // only the binary transport reads it
+    if (useBinary())
+        return callBinary(opcode) != 0;
+
     printf("%s\n", command);
     fflush(stdout);
     char response[BUFFER_SIZE];
@@ -36,100 +109,140 @@ int getAck(char *command)
 
 int API_mazeWidth()
 {
-    return getInteger("mazeWidth");
+    return getInteger(OP_MAZE_WIDTH, "mazeWidth");
 }
 
 int API_mazeHeight()
 {
-    return getInteger("mazeHeight");
+    return getInteger(OP_MAZE_HEIGHT, "mazeHeight");
 }
 
 int API_wallFront()
 {
-    return getBoolean("wallFront");
+    return getBoolean(OP_WALL_FRONT, "wallFront");
 }
 
 int API_wallRight()
 {
-    return getBoolean("wallRight");
+    return getBoolean(OP_WALL_RIGHT, "wallRight");
 }
 
 int API_wallLeft()
 {
-    return getBoolean("wallLeft");
+    return getBoolean(OP_WALL_LEFT, "wallLeft");
 }
 
 int API_moveForward()
 {
-    return getAck("moveForward");
+    return getAck(OP_MOVE_FORWARD, "moveForward");
 }
 
 void API_turnRight()
 {
-    getAck("turnRight");
+    getAck(OP_TURN_RIGHT, "turnRight");
 }
 
 void API_turnLeft()
 {
-    getAck("turnLeft");
+    getAck(OP_TURN_LEFT, "turnLeft");
 }
 
 void API_setWall(int x, int y, char direction)
 {
+    if (useBinary())
+    {
+        sendBinary(OP_SET_WALL, x, y, direction, NULL);
+        return;
+    }
     printf("setWall %d %d %c\n", x, y, direction);
     fflush(stdout);
 }
 
 void API_clearWall(int x, int y, char direction)
 {
+    if (useBinary())
+    {
+        sendBinary(OP_CLEAR_WALL, x, y, direction, NULL);
+        return;
+    }
     printf("clearWall %d %d %c\n", x, y, direction);
     fflush(stdout);
 }
 
 void API_setColor(int x, int y, char color)
 {
+    if (useBinary())
+    {
+        sendBinary(OP_SET_COLOR, x, y, color, NULL);
+        return;
+    }
     printf("setColor %d %d %c\n", x, y, color);
     fflush(stdout);
 }
 
 void API_clearColor(int x, int y)
 {
+    if (useBinary())
+    {
+        sendBinary(OP_CLEAR_COLOR, x, y, 0, NULL);
+        return;
+    }
     printf("clearColor %d %d\n", x, y);
     fflush(stdout);
 }
 
 void API_clearAllColor()
 {
+    if (useBinary())
+    {
+        sendBinary(OP_CLEAR_ALL_COLOR, 0, 0, 0, NULL);
+        return;
+    }
     printf("clearAllColor\n");
     fflush(stdout);
 }
 
 void API_setText(int x, int y, char *text)
 {
+    if (useBinary())
+    {
+        sendBinary(OP_SET_TEXT, x, y, 0, text);
+        return;
+    }
     printf("setText %d %d %s\n", x, y, text);
     fflush(stdout);
 }
 
 void API_clearText(int x, int y)
 {
+    if (useBinary())
+    {
+        sendBinary(OP_CLEAR_TEXT, x, y, 0, NULL);
+        return;
+    }
     printf("clearText %d %d\n", x, y);
     fflush(stdout);
 }
 
 void API_clearAllText()
 {
+    if (useBinary())
+    {
+        sendBinary(OP_CLEAR_ALL_TEXT, 0, 0, 0, NULL);
+        return;
+    }
     printf("clearAllText\n");
     fflush(stdout);
 }
 
 int API_wasReset()
 {
-    return getBoolean("wasReset");
+    return getBoolean(OP_WAS_RESET, "wasReset");
 }
 
 void API_ackReset()
 {
-    getAck("ackReset");
+    getAck(OP_ACK_RESET, "ackReset");
 }
 
 void debug_log(char *text)
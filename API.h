@@ -1,16 +1,42 @@
 #pragma once
 
+// Hardware abstraction layer between the solver and the mouse.
+//
+// The host build implements it in API.c over the mms text protocol. An MCU
+// build (-DMAZE_EMBEDDED) leaves API.c out and links the board's own
+// implementation of the same functions, so solver.c is identical on both.
+// tools/budget.c is a Linux stub of this interface for host measurements.
+
+// ===== Maze =====
 int API_mazeWidth();
 int API_mazeHeight();
 
+// ===== Sensors ===== (1 = wall)
 int API_wallFront();
 int API_wallRight();
 int API_wallLeft();
 
+// ===== Motion =====
 int API_moveForward(); // Returns 0 if crash, else returns 1
 void API_turnRight();
 void API_turnLeft();
 
+int API_wasReset();
+void API_ackReset();
+
+// ===== Display (optional) =====
+// Boards without a display build with -DMAZE_NO_DISPLAY and these calls
+// compile away.
+#ifdef MAZE_NO_DISPLAY
+#define API_setWall(x, y, direction) ((void)0)
+#define API_clearWall(x, y, direction) ((void)0)
+#define API_setColor(x, y, color) ((void)0)
+#define API_clearColor(x, y) ((void)0)
+#define API_clearAllColor() ((void)0)
+#define API_setText(x, y, str) ((void)0)
+#define API_clearText(x, y) ((void)0)
+#define API_clearAllText() ((void)0)
+#else
 void API_setWall(int x, int y, char direction);
 void API_clearWall(int x, int y, char direction);
 
@@ -21,8 +47,12 @@ void API_clearAllColor();
 void API_setText(int x, int y, char *str);
 void API_clearText(int x, int y);
 void API_clearAllText();
-
-int API_wasReset();
-void API_ackReset();
-
-void debug_log(char *text);
\ No newline at end of file
+#endif
+
+// ===== Logging =====
+// No stdio on the MCU: the embedded profile drops every log call.
+#ifdef MAZE_EMBEDDED
+#define debug_log(text) ((void)0)
+#else
+void debug_log(char *text);
+#endif
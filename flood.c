@@ -0,0 +1,57 @@
+#include "flood.h"
+#include "solver.h"
+
+void floodWalls(const unsigned char *walls, int width, int height,
+                const int *goals, int goalCount, int *dist, int *queue)
+{
+    int cells = width * height;
+    for (int i = 0; i < cells; i++)
+        dist[i] = -1;
+
+    int head = 0, tail = 0;
+    for (int i = 0; i < goalCount; i++)
+    {
+        if (dist[goals[i]] < 0)
+        {
+            dist[goals[i]] = 0;
+            queue[tail++] = goals[i];
+        }
+    }
+
+    while (head < tail)
+    {
+        int current = queue[head++];
+        for (int i = 0; i < 4; i++)
+        {
+            if (!wallsOpen(walls, width, height, current, i))
+                continue;
+            int next = current + dRow[i] * width + dCol[i];
+            if (dist[next] >= 0)
+                continue;
+
+            dist[next] = dist[current] + 1;
+            queue[tail++] = next;
+        }
+    }
+}
+
+int wallsOpen(const unsigned char *walls, int width, int height, int cell, int dir)
+{
+    int nr = cell / width + dRow[dir];
+    int nc = cell % width + dCol[dir];
+    if (nr < 0 || nr >= height || nc < 0 || nc >= width)
+        return 0;
+    // walls are stored on both sides, checking both tolerates a half-known wall
+    return !(walls[cell] & dirMask[dir]) && !(walls[nr * width + nc] & dirMask[(dir + 2) % 4]);
+}
+
+int centerGoals(int width, int height, int *goals)
+{
+    int count = 0;
+    for (int r = (height - 1) / 2; r <= height / 2; r++)
+    {
+        for (int c = (width - 1) / 2; c <= width / 2; c++)
+            goals[count++] = r * width + c;
+    }
+    return count;
+}
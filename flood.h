@@ -0,0 +1,22 @@
+#ifndef FLOOD_H
+#define FLOOD_H
+
+// Flood fill over a plain wall map, for code that cannot share the solver's
+// global maze (several robots, a server with many mazes).
+//
+// walls holds width * height WALL_* bitmasks, row-major with row 0 on the
+// north edge. Walls missing from the map count as open, like floodFill().
+// dist receives the number of steps to the nearest goal cell, or -1 when no
+// goal is reachable. queue is scratch space for width * height ints.
+void floodWalls(const unsigned char *walls, int width, int height,
+                const int *goals, int goalCount, int *dist, int *queue);
+
+// Whether a mouse in cell can step towards dir: the neighbor is on the map
+// and neither side of the shared edge has a wall.
+int wallsOpen(const unsigned char *walls, int width, int height, int cell, int dir);
+
+// Cells of the center goal block (4 cells, or fewer for odd sizes) in goals[].
+// Returns how many were written.
+int centerGoals(int width, int height, int *goals);
+
+#endif
@@ -0,0 +1,579 @@
+#include "hpa.h"
+#include "API.h"
+
+#define HPA_CLUSTER_CELLS (HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE)
+#define HPA_NODE_COUNT (HPA_CLUSTER_COUNT * HPA_MAX_ENTRANCES)
+#define HPA_UNREACHABLE 0xFFFF
+#define HPA_INF 0x3FFFFFFF
+// open border segments at least this long get an entrance at both ends,
+// shorter ones a single entrance in the middle
+#define HPA_LONG_SEGMENT 6
+
+// Entrances are stored by slot = side * HPA_MAX_SIDE_ENTRANCES + k, where k counts
+// the entrances along that side. Both clusters of a border find the same
+// segments in the same order, so the k-th entrance on our east side is the
+// k-th entrance on the neighbor's west side.
+typedef struct
+{
+    unsigned char count[4]; // entrances on the N/E/S/W side
+    unsigned char dirty;
+    short row[HPA_MAX_ENTRANCES]; // entrance cell for each slot
+    short col[HPA_MAX_ENTRANCES];
+    unsigned short dist[HPA_MAX_ENTRANCES][HPA_MAX_ENTRANCES]; // entrance to entrance, inside the cluster
+    unsigned short goalDist[HPA_MAX_ENTRANCES];                 // entrance to the nearest goal cell in the cluster
+} HpaCluster;
+
+static HpaCluster clusters[HPA_CLUSTER_COUNT];
+static int dirtyList[HPA_CLUSTER_COUNT];
+static int dirtyCount = 0;
+
+// abstract graph: node = cluster * HPA_MAX_ENTRANCES + slot. goalCost is a
+// distance field over it rooted at the goal: the length of the best abstract
+// route from the entrance to a goal cell (HPA_INF if none), and nextNode the
+// entrance that route visits next (-1 = straight to the goal inside the
+// cluster). It is repaired as clusters are rebuilt, so a step only looks up
+// the entrances of its own cluster.
+static int goalCost[HPA_NODE_COUNT];
+static int nextNode[HPA_NODE_COUNT];
+static unsigned char stale[HPA_NODE_COUNT]; // cost may have gone up, being repaired
+static int staleList[HPA_NODE_COUNT];
+static int staleCount = 0;
+
+// indexed min-heap on goalCost for the repair
+static int heap[HPA_NODE_COUNT];
+static int heapPos[HPA_NODE_COUNT]; // -1 when not in the heap
+static int heapSize = 0;
+
+// scratch for a BFS restricted to one cluster, indexed by local cell
+static unsigned short localDist[HPA_CLUSTER_CELLS];
+static short localParent[HPA_CLUSTER_CELLS];
+static short localQueue[HPA_CLUSTER_CELLS];
+
+// unknown walls are treated as open, like floodFill()
+static int canMove(int r, int c, int dir)
+{
+    int nr = r + dRow[dir];
+    int nc = c + dCol[dir];
+    if (nr < 0 || nr >= GRID_SIZE || nc < 0 || nc >= GRID_SIZE)
+        return 0;
+    int opposite = (dir + 2) % 4;
+    return !(maze[r][c].walls & dirMask[dir]) && !(maze[nr][nc].walls & dirMask[opposite]);
+}
+
+static int slotValid(const HpaCluster *cl, int slot)
+{
+    return slot % HPA_MAX_SIDE_ENTRANCES < cl->count[slot / HPA_MAX_SIDE_ENTRANCES];
+}
+
+static int clusterTop(int id)
+{
+    return (id / HPA_CLUSTERS_PER_SIDE) * HPA_CLUSTER_SIZE;
+}
+
+static int clusterLeft(int id)
+{
+    return (id % HPA_CLUSTERS_PER_SIDE) * HPA_CLUSTER_SIZE;
+}
+
+// i-th cell along one side of a cluster
+static void borderCell(int top, int left, int side, int i, int *r, int *c)
+{
+    if (side == NORTH)
+    {
+        *r = top;
+        *c = left + i;
+    }
+    else if (side == SOUTH)
+    {
+        *r = top + HPA_CLUSTER_SIZE - 1;
+        *c = left + i;
+    }
+    else if (side == WEST)
+    {
+        *r = top + i;
+        *c = left;
+    }
+    else
+    {
+        *r = top + i;
+        *c = left + HPA_CLUSTER_SIZE - 1;
+    }
+}
+
+static void addEntrance(HpaCluster *cl, int top, int left, int side, int i)
+{
+    if (cl->count[side] >= HPA_MAX_SIDE_ENTRANCES)
+    {
+        debug_log("Error in hpa: too many entrances on one side");
+        return;
+    }
+    int slot = side * HPA_MAX_SIDE_ENTRANCES + cl->count[side];
+    int r, c;
+    borderCell(top, left, side, i, &r, &c);
+    cl->row[slot] = r;
+    cl->col[slot] = c;
+    cl->count[side]++;
+}
+
+// A segment is a run of border crossings whose cells are also connected along
+// the border on both sides, so every cell of it reaches its entrance without
+// leaving either cluster.
+static void findEntrances(HpaCluster *cl, int top, int left, int side)
+{
+    cl->count[side] = 0;
+    int along = (side == NORTH || side == SOUTH) ? EAST : SOUTH;
+    int start = -1;
+    for (int i = 0; i <= HPA_CLUSTER_SIZE; i++)
+    {
+        int open = 0;
+        int linked = 0;
+        if (i < HPA_CLUSTER_SIZE)
+        {
+            int r, c;
+            borderCell(top, left, side, i, &r, &c);
+            open = canMove(r, c, side);
+            if (open && i > 0)
+            {
+                int pr = r - dRow[along];
+                int pc = c - dCol[along];
+                linked = canMove(pr, pc, along) && canMove(pr + dRow[side], pc + dCol[side], along);
+            }
+        }
+
+        if (start >= 0 && !(open && linked))
+        {
+            int end = i - 1;
+            if (end - start + 1 >= HPA_LONG_SEGMENT)
+            {
+                addEntrance(cl, top, left, side, start);
+                addEntrance(cl, top, left, side, end);
+            }
+            else
+            {
+                addEntrance(cl, top, left, side, start + (end - start) / 2);
+            }
+            start = -1;
+        }
+        if (open && start < 0)
+            start = i;
+    }
+}
+
+// BFS from (row, col) that never leaves the cluster at (top, left)
+static void clusterBfs(int top, int left, int row, int col)
+{
+    for (int i = 0; i < HPA_CLUSTER_CELLS; i++)
+        localDist[i] = HPA_UNREACHABLE;
+
+    int start = (row - top) * HPA_CLUSTER_SIZE + (col - left);
+    localDist[start] = 0;
+    localParent[start] = -1;
+
+    int head = 0, tail = 0;
+    localQueue[tail++] = start;
+    while (head < tail)
+    {
+        int current = localQueue[head++];
+        int r = top + current / HPA_CLUSTER_SIZE;
+        int c = left + current % HPA_CLUSTER_SIZE;
+
+        for (int i = 0; i < 4; i++)
+        {
+            int nr = r + dRow[i];
+            int nc = c + dCol[i];
+            if (nr < top || nr >= top + HPA_CLUSTER_SIZE || nc < left || nc >= left + HPA_CLUSTER_SIZE)
+                continue;
+            if (!canMove(r, c, i))
+                continue;
+
+            int next = (nr - top) * HPA_CLUSTER_SIZE + (nc - left);
+            if (localDist[next] != HPA_UNREACHABLE)
+                continue;
+            localDist[next] = localDist[current] + 1;
+            localParent[next] = current;
+            localQueue[tail++] = next;
+        }
+    }
+}
+
+static int localIndex(int top, int left, int r, int c)
+{
+    return (r - top) * HPA_CLUSTER_SIZE + (c - left);
+}
+
+static void buildCluster(int id)
+{
+    HpaCluster *cl = &clusters[id];
+    int top = clusterTop(id);
+    int left = clusterLeft(id);
+
+    for (int side = 0; side < 4; side++)
+        findEntrances(cl, top, left, side);
+
+    int goal = GRID_SIZE / 2;
+    for (int a = 0; a < HPA_MAX_ENTRANCES; a++)
+    {
+        if (!slotValid(cl, a))
+            continue;
+
+        clusterBfs(top, left, cl->row[a], cl->col[a]);
+
+        for (int b = 0; b < HPA_MAX_ENTRANCES; b++)
+        {
+            if (slotValid(cl, b))
+                cl->dist[a][b] = localDist[localIndex(top, left, cl->row[b], cl->col[b])];
+        }
+
+        cl->goalDist[a] = HPA_UNREACHABLE;
+        for (int r = goal - 1; r <= goal; r++)
+        {
+            for (int c = goal - 1; c <= goal; c++)
+            {
+                if (r < top || r >= top + HPA_CLUSTER_SIZE || c < left || c >= left + HPA_CLUSTER_SIZE)
+                    continue;
+                unsigned short d = localDist[localIndex(top, left, r, c)];
+                if (d < cl->goalDist[a])
+                    cl->goalDist[a] = d;
+            }
+        }
+    }
+
+    cl->dirty = 0;
+}
+
+void hpaInit()
+{
+    dirtyCount = 0;
+    for (int id = 0; id < HPA_CLUSTER_COUNT; id++)
+    {
+        clusters[id].dirty = 1;
+        dirtyList[dirtyCount++] = id;
+    }
+
+    // every cluster is dirty, so the first repair rebuilds the whole field
+    heapSize = 0;
+    for (int node = 0; node < HPA_NODE_COUNT; node++)
+    {
+        heapPos[node] = -1;
+        stale[node] = 0;
+    }
+}
+
+static void markDirty(int cr, int cc)
+{
+    if (cr < 0 || cr >= HPA_CLUSTERS_PER_SIDE || cc < 0 || cc >= HPA_CLUSTERS_PER_SIDE)
+        return;
+    int id = cr * HPA_CLUSTERS_PER_SIDE + cc;
+    if (!clusters[id].dirty)
+    {
+        clusters[id].dirty = 1;
+        dirtyList[dirtyCount++] = id;
+    }
+}
+
+void hpaInvalidate(int r, int c)
+{
+    int cr = r / HPA_CLUSTER_SIZE;
+    int cc = c / HPA_CLUSTER_SIZE;
+    markDirty(cr, cc);
+
+    // border cells also decide the entrances of the cluster across that border
+    if (r % HPA_CLUSTER_SIZE == 0)
+        markDirty(cr - 1, cc);
+    if (r % HPA_CLUSTER_SIZE == HPA_CLUSTER_SIZE - 1)
+        markDirty(cr + 1, cc);
+    if (c % HPA_CLUSTER_SIZE == 0)
+        markDirty(cr, cc - 1);
+    if (c % HPA_CLUSTER_SIZE == HPA_CLUSTER_SIZE - 1)
+        markDirty(cr, cc + 1);
+}
+
+// ===== goal distance field over the entrances =====
+
+static void heapSwap(int i, int j)
+{
+    int tmp = heap[i];
+    heap[i] = heap[j];
+    heap[j] = tmp;
+    heapPos[heap[i]] = i;
+    heapPos[heap[j]] = j;
+}
+
+static void heapUp(int i)
+{
+    while (i > 0)
+    {
+        int parent = (i - 1) / 2;
+        if (goalCost[heap[parent]] <= goalCost[heap[i]])
+            break;
+        heapSwap(i, parent);
+        i = parent;
+    }
+}
+
+static void heapDown(int i)
+{
+    while (1)
+    {
+        int smallest = i;
+        int l = 2 * i + 1;
+        int r = 2 * i + 2;
+        if (l < heapSize && goalCost[heap[l]] < goalCost[heap[smallest]])
+            smallest = l;
+        if (r < heapSize && goalCost[heap[r]] < goalCost[heap[smallest]])
+            smallest = r;
+        if (smallest == i)
+            break;
+        heapSwap(i, smallest);
+        i = smallest;
+    }
+}
+
+static int heapPop()
+{
+    int top = heap[0];
+    heapSize--;
+    if (heapSize > 0)
+    {
+        heap[0] = heap[heapSize];
+        heapPos[heap[0]] = 0;
+        heapDown(0);
+    }
+    heapPos[top] = -1;
+    return top;
+}
+
+// insert node, or move it up after its goalCost went down
+static void heapUpdate(int node)
+{
+    if (heapPos[node] < 0)
+    {
+        heap[heapSize] = node;
+        heapPos[node] = heapSize;
+        heapSize++;
+    }
+    heapUp(heapPos[node]);
+}
+
+// node on the other side of the border crossing, or -1
+static int peerOf(int node)
+{
+    int id = node / HPA_MAX_ENTRANCES;
+    int slot = node % HPA_MAX_ENTRANCES;
+    int side = slot / HPA_MAX_SIDE_ENTRANCES;
+    int k = slot % HPA_MAX_SIDE_ENTRANCES;
+
+    int other = id + dRow[side] * HPA_CLUSTERS_PER_SIDE + dCol[side];
+    int otherSlot = ((side + 2) % 4) * HPA_MAX_SIDE_ENTRANCES + k;
+    if (!slotValid(&clusters[other], otherSlot))
+        return -1;
+    return other * HPA_MAX_ENTRANCES + otherSlot;
+}
+
+// Edges of a valid node into to[] and cost[] (room for HPA_MAX_ENTRANCES):
+// the crossing to its peer and the paths to the other entrances of its
+// cluster. Every edge has the same cost both ways. Returns the count.
+static int edgesOf(int node, int *to, int *cost)
+{
+    int id = node / HPA_MAX_ENTRANCES;
+    int slot = node % HPA_MAX_ENTRANCES;
+    HpaCluster *cl = &clusters[id];
+    int n = 0;
+
+    int peer = peerOf(node);
+    if (peer >= 0)
+    {
+        to[n] = peer;
+        cost[n++] = 1;
+    }
+    for (int b = 0; b < HPA_MAX_ENTRANCES; b++)
+    {
+        if (b == slot || !slotValid(cl, b) || cl->dist[slot][b] == HPA_UNREACHABLE)
+            continue;
+        to[n] = id * HPA_MAX_ENTRANCES + b;
+        cost[n++] = cl->dist[slot][b];
+    }
+    return n;
+}
+
+static void markStale(int node)
+{
+    if (!stale[node])
+    {
+        stale[node] = 1;
+        staleList[staleCount++] = node;
+    }
+}
+
+// Bring goalCost up to date after the clusters in rebuilt[] were rebuilt.
+// Walls only cut routes, so the costs that can go up are those of the
+// rebuilt clusters' entrances (renumbered by the rebuild) and of every
+// entrance whose best route runs through one of them, found by following
+// nextNode backwards. Those are seeded from their neighbors that kept their
+// cost, and a Dijkstra from the seeds settles them. A rebuilt cluster can
+// also gain an entrance that shortens other routes; the same pass lowers
+// them. The work grows with the part of the field that changed, not with
+// the grid.
+static void repairGoalField(const int *rebuilt, int count)
+{
+    int to[HPA_MAX_ENTRANCES];
+    int cost[HPA_MAX_ENTRANCES];
+
+    staleCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+        for (int slot = 0; slot < HPA_MAX_ENTRANCES; slot++)
+            markStale(rebuilt[i] * HPA_MAX_ENTRANCES + slot);
+    }
+    for (int i = 0; i < staleCount; i++)
+    {
+        int w = staleList[i];
+        if (!slotValid(&clusters[w / HPA_MAX_ENTRANCES], w % HPA_MAX_ENTRANCES))
+            continue;
+        int n = edgesOf(w, to, cost);
+        for (int k = 0; k < n; k++)
+        {
+            if (nextNode[to[k]] == w)
+                markStale(to[k]);
+        }
+    }
+
+    // seed every stale entrance from the goal in its cluster and the
+    // neighbors whose cost still holds
+    for (int i = 0; i < staleCount; i++)
+    {
+        int v = staleList[i];
+        HpaCluster *cl = &clusters[v / HPA_MAX_ENTRANCES];
+        int slot = v % HPA_MAX_ENTRANCES;
+        goalCost[v] = HPA_INF;
+        nextNode[v] = -1;
+        if (!slotValid(cl, slot))
+            continue;
+        if (cl->goalDist[slot] != HPA_UNREACHABLE)
+            goalCost[v] = cl->goalDist[slot];
+        int n = edgesOf(v, to, cost);
+        for (int k = 0; k < n; k++)
+        {
+            if (!stale[to[k]] && goalCost[to[k]] < HPA_INF && goalCost[to[k]] + cost[k] < goalCost[v])
+            {
+                goalCost[v] = goalCost[to[k]] + cost[k];
+                nextNode[v] = to[k];
+            }
+        }
+    }
+    for (int i = 0; i < staleCount; i++)
+    {
+        int v = staleList[i];
+        stale[v] = 0;
+        if (goalCost[v] < HPA_INF)
+            heapUpdate(v);
+    }
+
+    while (heapSize > 0)
+    {
+        int u = heapPop();
+        int n = edgesOf(u, to, cost);
+        for (int k = 0; k < n; k++)
+        {
+            if (goalCost[u] + cost[k] < goalCost[to[k]])
+            {
+                goalCost[to[k]] = goalCost[u] + cost[k];
+                nextNode[to[k]] = u;
+                heapUpdate(to[k]);
+            }
+        }
+    }
+}
+
+int hpaNextCell(int row, int col, int *nextRow, int *nextCol)
+{
+    *nextRow = row;
+    *nextCol = col;
+
+    // only clusters touched by new walls are rebuilt, and only the routes
+    // through them are searched again
+    if (dirtyCount > 0)
+    {
+        for (int i = 0; i < dirtyCount; i++)
+            buildCluster(dirtyList[i]);
+        repairGoalField(dirtyList, dirtyCount);
+        dirtyCount = 0;
+    }
+
+    int id = (row / HPA_CLUSTER_SIZE) * HPA_CLUSTERS_PER_SIDE + col / HPA_CLUSTER_SIZE;
+    HpaCluster *cl = &clusters[id];
+    int top = clusterTop(id);
+    int left = clusterLeft(id);
+    clusterBfs(top, left, row, col);
+    int here = localIndex(top, left, row, col);
+
+    // a goal cell inside this cluster may be reachable without leaving it
+    int best = HPA_INF;
+    int target = -1;
+    int goal = GRID_SIZE / 2;
+    for (int r = goal - 1; r <= goal; r++)
+    {
+        for (int c = goal - 1; c <= goal; c++)
+        {
+            if (r < top || r >= top + HPA_CLUSTER_SIZE || c < left || c >= left + HPA_CLUSTER_SIZE)
+                continue;
+            int idx = localIndex(top, left, r, c);
+            if (localDist[idx] < best)
+            {
+                best = localDist[idx];
+                target = idx;
+            }
+        }
+    }
+    if (target == here)
+        return 0; // already on the goal
+
+    // otherwise head for the entrance of this cluster with the shortest way
+    // on, or cross the border from the entrance we are standing on
+    int cross = -1;
+    for (int slot = 0; slot < HPA_MAX_ENTRANCES; slot++)
+    {
+        int node = id * HPA_MAX_ENTRANCES + slot;
+        if (!slotValid(cl, slot) || goalCost[node] >= HPA_INF)
+            continue;
+        int entrance = localIndex(top, left, cl->row[slot], cl->col[slot]);
+        if (localDist[entrance] == HPA_UNREACHABLE)
+            continue;
+        if (entrance == here)
+        {
+            int peer = peerOf(node);
+            if (peer >= 0 && goalCost[peer] < HPA_INF && 1 + goalCost[peer] < best)
+            {
+                best = 1 + goalCost[peer];
+                cross = peer;
+            }
+        }
+        else if (localDist[entrance] + goalCost[node] < best)
+        {
+            best = localDist[entrance] + goalCost[node];
+            target = entrance;
+            cross = -1;
+        }
+    }
+
+    if (cross >= 0)
+    {
+        // border crossing into the neighbor cluster
+        *nextRow = clusters[cross / HPA_MAX_ENTRANCES].row[cross % HPA_MAX_ENTRANCES];
+        *nextCol = clusters[cross / HPA_MAX_ENTRANCES].col[cross % HPA_MAX_ENTRANCES];
+        return 1;
+    }
+    if (target < 0)
+    {
+        debug_log("hpa: no route to goal");
+        return 0;
+    }
+
+    // walk back from the target to the first step out of the current cell
+    while (localParent[target] != here)
+        target = localParent[target];
+
+    *nextRow = top + target / HPA_CLUSTER_SIZE;
+    *nextCol = left + target % HPA_CLUSTER_SIZE;
+    return 1;
+}
@@ -0,0 +1,46 @@
+#ifndef HPA_H
+#define HPA_H
+
+#include "solver.h"
+
+// Hierarchical path planner (HPA* style) for large generated mazes.
+//
+// The grid is split into HPA_CLUSTER_SIZE x HPA_CLUSTER_SIZE clusters. Each open
+// stretch of a cluster border gets one or two entrances, and every cluster keeps
+// the distances between its own entrances. The entrances form an abstract graph
+// with a distance field rooted at the goal; a rebuild repairs the field only
+// where routes ran through the rebuilt clusters, so a step costs a search of
+// the robot's own cluster plus a lookup of its entrances.
+//
+// addWall() calls hpaInvalidate() for every new wall, which marks the cluster
+// owning that cell for a rebuild. Entrances depend on the cells on both sides of
+// a border, so a wall on a border cell also marks the cluster across it. Build with
+// -DUSE_HPA to make solver() use this planner instead of floodFill().
+
+#ifndef HPA_CLUSTER_SIZE
+#define HPA_CLUSTER_SIZE 8
+#endif
+
+#if GRID_SIZE % HPA_CLUSTER_SIZE != 0
+#error "GRID_SIZE must be a multiple of HPA_CLUSTER_SIZE"
+#endif
+
+#define HPA_CLUSTERS_PER_SIDE (GRID_SIZE / HPA_CLUSTER_SIZE)
+#define HPA_CLUSTER_COUNT (HPA_CLUSTERS_PER_SIDE * HPA_CLUSTERS_PER_SIDE)
+
+// worst case every border cell is its own segment
+#define HPA_MAX_SIDE_ENTRANCES HPA_CLUSTER_SIZE
+#define HPA_MAX_ENTRANCES (4 * HPA_MAX_SIDE_ENTRANCES)
+
+// Mark every cluster for a rebuild (call after initSet()).
+void hpaInit();
+
+// Mark the cluster that owns cell (r, c) (and any cluster sharing its border) for a rebuild.
+void hpaInvalidate(int r, int c);
+
+// Pick the neighbor of (row, col) to move to next on the way to the goal.
+// The result is always a neighbor of (row, col). Returns 0 (and the current
+// cell) when the robot is on the goal or no route is known.
+int hpaNextCell(int row, int col, int *nextRow, int *nextCol);
+
+#endif
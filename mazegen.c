@@ -0,0 +1,491 @@
+#define _POSIX_C_SOURCE 199309L // clock_gettime
+#include "mazegen.h"
+#include "solver.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// only macros and the movement tables come from solver.h, so the generator
+// links without the solver or the simulator API
+
+#define ALL_WALLS (WALL_N | WALL_E | WALL_S | WALL_W)
+
+static const char *algorithmNames[] = {"backtracker", "kruskal", "wilson", "braided", "competition"};
+
+// ===== random numbers =====
+// splitmix64: tiny, fast and identical on every platform, unlike rand()
+
+typedef struct
+{
+    unsigned long long state;
+} MazeRng;
+
+static unsigned long long nextRandom(MazeRng *rng)
+{
+    unsigned long long z = (rng->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// uniform in [0, n)
+static unsigned int randomBelow(MazeRng *rng, unsigned int n)
+{
+    return (unsigned int)(((nextRandom(rng) >> 32) * n) >> 32);
+}
+
+static double randomUnit(MazeRng *rng)
+{
+    return (nextRandom(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// ===== maze storage =====
+
+Maze *createMaze(int width, int height)
+{
+    Maze *maze = (Maze *)malloc(sizeof(Maze));
+    if (!maze)
+        return NULL;
+    maze->width = width;
+    maze->height = height;
+    maze->walls = (unsigned char *)malloc((size_t)width * height);
+    maze->scratch = (int *)malloc(sizeof(int) * 3 * (size_t)width * height);
+    if (!maze->walls || !maze->scratch)
+    {
+        freeMaze(maze);
+        return NULL;
+    }
+    memset(maze->walls, ALL_WALLS, (size_t)width * height);
+    return maze;
+}
+
+void freeMaze(Maze *maze)
+{
+    if (!maze)
+        return;
+    free(maze->walls);
+    free(maze->scratch);
+    free(maze);
+}
+
+int mazeHasWall(const Maze *maze, int row, int col, int dir)
+{
+    return (maze->walls[row * maze->width + col] & dirMask[dir]) != 0;
+}
+
+static int inside(const Maze *maze, int row, int col)
+{
+    return row >= 0 && row < maze->height && col >= 0 && col < maze->width;
+}
+
+// remove the wall on side dir of cell and the matching wall of its neighbor
+static void carve(Maze *maze, int cell, int dir)
+{
+    int next = cell + dRow[dir] * maze->width + dCol[dir];
+    maze->walls[cell] &= ~dirMask[dir];
+    maze->walls[next] &= ~dirMask[(dir + 2) % 4];
+}
+
+// neighbor cell of cell in direction dir, or -1 outside the maze
+static int neighbor(const Maze *maze, int cell, int dir)
+{
+    int r = cell / maze->width + dRow[dir];
+    int c = cell % maze->width + dCol[dir];
+    return inside(maze, r, c) ? r * maze->width + c : -1;
+}
+
+// the 2x2 center block (a single row/column when that dimension is odd)
+static int isGoal(const Maze *maze, int cell)
+{
+    int r = cell / maze->width;
+    int c = cell % maze->width;
+    int gr = maze->height / 2;
+    int gc = maze->width / 2;
+    int rowOk = (r == gr) || (maze->height % 2 == 0 && r == gr - 1);
+    int colOk = (c == gc) || (maze->width % 2 == 0 && c == gc - 1);
+    return rowOk && colOk;
+}
+
+// ===== generators =====
+
+static void backtracker(Maze *maze, MazeRng *rng)
+{
+    int n = maze->width * maze->height;
+    int *stack = maze->scratch;
+    int *visited = maze->scratch + n;
+    memset(visited, 0, sizeof(int) * n);
+
+    int start = (maze->height - 1) * maze->width; // bottom-left
+    int top = 0;
+    stack[top++] = start;
+    visited[start] = 1;
+
+    while (top > 0)
+    {
+        int cell = stack[top - 1];
+        int options[4];
+        int count = 0;
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int next = neighbor(maze, cell, dir);
+            if (next >= 0 && !visited[next])
+                options[count++] = dir;
+        }
+
+        if (count == 0)
+        {
+            top--;
+            continue;
+        }
+
+        int dir = options[randomBelow(rng, count)];
+        int next = neighbor(maze, cell, dir);
+        carve(maze, cell, dir);
+        visited[next] = 1;
+        stack[top++] = next;
+    }
+}
+
+// competition rules: keep the single goal entrance and the start wall
+static int isProtected(const Maze *maze, int cell, int dir, int competition)
+{
+    if (!competition)
+        return 0;
+    int start = (maze->height - 1) * maze->width;
+    if ((cell == start && dir == EAST) || (cell == start + 1 && dir == WEST))
+        return 1;
+    return isGoal(maze, cell) != isGoal(maze, neighbor(maze, cell, dir));
+}
+
+static int findSet(int *parent, int x)
+{
+    while (parent[x] != x)
+    {
+        parent[x] = parent[parent[x]]; // path halving
+        x = parent[x];
+    }
+    return x;
+}
+
+// Kruskal over all interior walls in random order. For competition mazes the
+// goal block is opened inside and left out of the spanning tree, then joined
+// to it through one random perimeter wall; the wall east of the start cell is
+// never a candidate.
+static void kruskal(Maze *maze, MazeRng *rng, int competition)
+{
+    int w = maze->width;
+    int n = w * maze->height;
+    int *edges = maze->scratch;         // cell * 2 + (0 = east wall, 1 = south wall)
+    int *parent = maze->scratch + 2 * n;
+
+    int edgeCount = 0;
+    for (int cell = 0; cell < n; cell++)
+    {
+        parent[cell] = cell;
+        if (cell % w < w - 1 && !isProtected(maze, cell, EAST, competition))
+            edges[edgeCount++] = cell * 2;
+        if (cell / w < maze->height - 1 && !isProtected(maze, cell, SOUTH, competition))
+            edges[edgeCount++] = cell * 2 + 1;
+    }
+
+    if (competition)
+    {
+        int root = -1;
+        for (int cell = 0; cell < n; cell++)
+        {
+            if (!isGoal(maze, cell))
+                continue;
+            if (root < 0)
+            {
+                root = cell;
+                continue;
+            }
+            parent[cell] = root;
+            // open the walls inside the goal block
+            if (cell % w > 0 && isGoal(maze, cell - 1))
+                carve(maze, cell, WEST);
+            if (cell / w > 0 && isGoal(maze, cell - w))
+                carve(maze, cell, NORTH);
+        }
+    }
+
+    // Fisher-Yates
+    for (int i = edgeCount - 1; i > 0; i--)
+    {
+        int j = randomBelow(rng, i + 1);
+        int tmp = edges[i];
+        edges[i] = edges[j];
+        edges[j] = tmp;
+    }
+
+    for (int i = 0; i < edgeCount; i++)
+    {
+        int cell = edges[i] / 2;
+        int dir = (edges[i] & 1) ? SOUTH : EAST;
+        int a = findSet(parent, cell);
+        int b = findSet(parent, neighbor(maze, cell, dir));
+        if (a == b)
+            continue;
+        parent[a] = b;
+        carve(maze, cell, dir);
+    }
+
+    if (competition)
+    {
+        // the single goal entrance, through any wall of the goal block
+        int doors[8];
+        int doorCount = 0;
+        for (int r = (maze->height - 1) / 2; r <= maze->height / 2; r++)
+        {
+            for (int c = (w - 1) / 2; c <= w / 2; c++)
+            {
+                for (int dir = 0; dir < 4; dir++)
+                {
+                    int next = neighbor(maze, r * w + c, dir);
+                    if (next >= 0 && !isGoal(maze, next))
+                        doors[doorCount++] = (r * w + c) * 4 + dir;
+                }
+            }
+        }
+        // below 3x3 the goal block is the whole maze and there is no door
+        if (doorCount > 0)
+        {
+            int door = doors[randomBelow(rng, doorCount)];
+            carve(maze, door / 4, door % 4);
+        }
+    }
+}
+
+static void wilson(Maze *maze, MazeRng *rng)
+{
+    int n = maze->width * maze->height;
+    int *nextDir = maze->scratch;
+    int *inTree = maze->scratch + n;
+    memset(inTree, 0, sizeof(int) * n);
+
+    inTree[randomBelow(rng, n)] = 1;
+
+    for (int start = 0; start < n; start++)
+    {
+        if (inTree[start])
+            continue;
+
+        // random walk until the tree is hit; overwriting nextDir erases loops
+        int cell = start;
+        while (!inTree[cell])
+        {
+            int dir, next;
+            do
+            {
+                dir = randomBelow(rng, 4);
+                next = neighbor(maze, cell, dir);
+            } while (next < 0);
+            nextDir[cell] = dir;
+            cell = next;
+        }
+
+        // add the loop-erased path to the tree
+        cell = start;
+        while (!inTree[cell])
+        {
+            inTree[cell] = 1;
+            carve(maze, cell, nextDir[cell]);
+            cell = neighbor(maze, cell, nextDir[cell]);
+        }
+    }
+}
+
+static int wallCount(const Maze *maze, int cell)
+{
+    unsigned char walls = maze->walls[cell];
+    return ((walls & WALL_N) != 0) + ((walls & WALL_E) != 0) + ((walls & WALL_S) != 0) + ((walls & WALL_W) != 0);
+}
+
+// open each dead end into a loop with probability loopRatio, preferring a
+// wall shared with another dead end
+static void braid(Maze *maze, MazeRng *rng, double loopRatio, int competition)
+{
+    int n = maze->width * maze->height;
+    for (int cell = 0; cell < n; cell++)
+    {
+        if (wallCount(maze, cell) != 3 || randomUnit(rng) >= loopRatio)
+            continue;
+
+        int options[4];
+        int count = 0;
+        int best = -1;
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int next = neighbor(maze, cell, dir);
+            if (next < 0 || !mazeHasWall(maze, cell / maze->width, cell % maze->width, dir) ||
+                isProtected(maze, cell, dir, competition))
+                continue;
+            options[count++] = dir;
+            if (wallCount(maze, next) == 3)
+                best = dir;
+        }
+
+        if (count == 0)
+            continue;
+        carve(maze, cell, best >= 0 ? best : options[randomBelow(rng, count)]);
+    }
+}
+
+void generateMaze(Maze *maze, MazeAlgorithm algorithm, unsigned long long seed, double loopRatio)
+{
+    MazeRng rng = {seed};
+    memset(maze->walls, ALL_WALLS, (size_t)maze->width * maze->height);
+
+    switch (algorithm)
+    {
+    case MAZE_BACKTRACKER:
+        backtracker(maze, &rng);
+        break;
+    case MAZE_KRUSKAL:
+        kruskal(maze, &rng, 0);
+        break;
+    case MAZE_WILSON:
+        wilson(maze, &rng);
+        break;
+    case MAZE_BRAIDED:
+        backtracker(maze, &rng);
+        braid(maze, &rng, loopRatio, 0);
+        break;
+    case MAZE_COMPETITION:
+        kruskal(maze, &rng, 1);
+        braid(maze, &rng, loopRatio, 1);
+        break;
+    }
+}
+
+int parseMazeAlgorithm(const char *name)
+{
+    for (int i = 0; i < (int)(sizeof(algorithmNames) / sizeof(algorithmNames[0])); i++)
+    {
+        if (strcmp(name, algorithmNames[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+const char *mazeAlgorithmName(MazeAlgorithm algorithm)
+{
+    return algorithmNames[algorithm];
+}
+
+// ===== files =====
+
+int writeMazeNum(const Maze *maze, FILE *file)
+{
+    for (int x = 0; x < maze->width; x++)
+    {
+        for (int y = 0; y < maze->height; y++)
+        {
+            int row = maze->height - 1 - y;
+            fprintf(file, "%d %d %d %d %d %d\n", x, y,
+                    mazeHasWall(maze, row, x, NORTH), mazeHasWall(maze, row, x, EAST),
+                    mazeHasWall(maze, row, x, SOUTH), mazeHasWall(maze, row, x, WEST));
+        }
+    }
+    return ferror(file) ? -1 : 0;
+}
+
+int writeMazeMap(const Maze *maze, FILE *file)
+{
+    for (int row = 0; row < maze->height; row++)
+    {
+        for (int col = 0; col < maze->width; col++)
+            fputs(mazeHasWall(maze, row, col, NORTH) ? "+---" : "+   ", file);
+        fputs("+\n", file);
+
+        for (int col = 0; col < maze->width; col++)
+            fputs(mazeHasWall(maze, row, col, WEST) ? "|   " : "    ", file);
+        fputs(mazeHasWall(maze, row, maze->width - 1, EAST) ? "|\n" : " \n", file);
+    }
+    for (int col = 0; col < maze->width; col++)
+        fputs("+---", file);
+    fputs("+\n", file);
+    return ferror(file) ? -1 : 0;
+}
+
+int saveMaze(const Maze *maze, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return -1;
+
+    size_t len = strlen(path);
+    int result;
+    if (len >= 4 && strcmp(path + len - 4, ".map") == 0)
+        result = writeMazeMap(maze, file);
+    else
+        result = writeMazeNum(maze, file);
+
+    if (fclose(file) != 0)
+        result = -1;
+    return result;
+}
+
+Maze *loadMazeNum(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return NULL;
+
+    // first pass: size
+    int x, y, n, e, s, w;
+    int width = 0, height = 0;
+    while (fscanf(file, "%d %d %d %d %d %d", &x, &y, &n, &e, &s, &w) == 6)
+    {
+        if (x + 1 > width)
+            width = x + 1;
+        if (y + 1 > height)
+            height = y + 1;
+    }
+
+    Maze *maze = NULL;
+    if (width > 0 && height > 0)
+        maze = createMaze(width, height);
+    if (!maze)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    // second pass: walls (the file lists both sides of each wall)
+    rewind(file);
+    memset(maze->walls, 0, (size_t)width * height);
+    while (fscanf(file, "%d %d %d %d %d %d", &x, &y, &n, &e, &s, &w) == 6)
+    {
+        if (x < 0 || y < 0)
+            continue;
+        unsigned char *cell = &maze->walls[(height - 1 - y) * width + x];
+        *cell = (n ? WALL_N : 0) | (e ? WALL_E : 0) | (s ? WALL_S : 0) | (w ? WALL_W : 0);
+    }
+
+    fclose(file);
+    return maze;
+}
+
+Maze *openMazeSpec(const char *spec)
+{
+    char name[32];
+    int size, end = 0;
+    unsigned long long seed;
+    if (sscanf(spec, "%31[a-z]:%d:%llu%n", name, &size, &seed, &end) == 3 && spec[end] == '\0')
+    {
+        int algorithm = parseMazeAlgorithm(name);
+        Maze *maze = algorithm >= 0 && size > 0 ? createMaze(size, size) : NULL;
+        if (maze)
+            generateMaze(maze, algorithm, seed, 0.5);
+        return maze;
+    }
+    return loadMazeNum(spec);
+}
+
+double benchSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
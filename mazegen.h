@@ -0,0 +1,64 @@
+#ifndef MAZEGEN_H
+#define MAZEGEN_H
+
+#include <stdio.h>
+
+// Seeded random maze generators for building benchmark corpora.
+//
+// A Maze stores one wall bitmask per cell (WALL_N/E/S/W from solver.h),
+// row-major with row 0 on the north edge, the same orientation as the
+// solver's grid. The start cell is the bottom-left corner. Every generator
+// is reproducible: the same algorithm, size, seed and loop ratio always give
+// the same maze.
+
+typedef enum MazeAlgorithm
+{
+    MAZE_BACKTRACKER, // recursive backtracker (long corridors, perfect)
+    MAZE_KRUSKAL,     // randomized Kruskal (short dead ends, perfect)
+    MAZE_WILSON,      // Wilson's loop-erased random walks (uniform spanning tree)
+    MAZE_BRAIDED,     // backtracker with a share of dead ends opened into loops
+    MAZE_COMPETITION  // center goal with one entrance, start wall on the east, loops
+} MazeAlgorithm;
+
+typedef struct Maze
+{
+    int width;
+    int height;
+    unsigned char *walls; // width * height wall bitmasks
+    int *scratch;         // work space for the generators, reused between runs
+} Maze;
+
+Maze *createMaze(int width, int height);
+void freeMaze(Maze *maze);
+
+// Regenerate the maze in place. loopRatio (0..1) is the share of dead ends
+// opened into loops for MAZE_BRAIDED and MAZE_COMPETITION; ignored otherwise.
+void generateMaze(Maze *maze, MazeAlgorithm algorithm, unsigned long long seed, double loopRatio);
+
+int mazeHasWall(const Maze *maze, int row, int col, int dir);
+
+// Algorithm names as used on the command line ("backtracker", "kruskal", ...).
+// parseMazeAlgorithm returns -1 for an unknown name.
+int parseMazeAlgorithm(const char *name);
+const char *mazeAlgorithmName(MazeAlgorithm algorithm);
+
+// Maze files in the simulator formats:
+// .num: one "x y N E S W" line per cell, x from the left, y from the bottom
+// .map: ASCII art with +---+ posts and | walls
+// saveMaze picks the format from the file extension. Return 0 on success.
+int writeMazeNum(const Maze *maze, FILE *file);
+int writeMazeMap(const Maze *maze, FILE *file);
+int saveMaze(const Maze *maze, const char *path);
+
+// Load a .num file. Returns NULL if the file cannot be read.
+Maze *loadMazeNum(const char *path);
+
+// The maze a tool is given on its command line: ALGORITHM:SIZE:SEED
+// generates a SIZE x SIZE maze (loop ratio 0.5), anything else is read as
+// a .num file. Returns NULL if the spec names neither.
+Maze *openMazeSpec(const char *spec);
+
+// Monotonic seconds, for the tools' timings and timeouts.
+double benchSeconds();
+
+#endif
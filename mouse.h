@@ -0,0 +1,120 @@
+#ifndef MOUSE_H
+#define MOUSE_H
+
+#include "solver.h"
+
+// The decision step of one mouse, shared by solver() and the robots of
+// robot.c so that a team explores with the same policy as the single mouse.
+// It sees only the distances around the mouse, never a maze or a field, so
+// each caller keeps its own walls and flood. static inline for the reason
+// dRow is static: including mouse.h does not drag solver.c into a build.
+
+// Where a mouse is and the rest of a move it has started: a U-turn is two
+// left turns and a FORWARD, taken over three steps without deciding again.
+typedef struct
+{
+    int row;
+    int col;
+    int heading;
+    int pendingTurns;      // 90-degree turns still due before the FORWARD
+    int pendingTurnIsLeft; // 1 => each pending turn is a left, 0 => a right
+    int forwardNext;       // the turns are done, the next step goes forward
+} MousePose;
+
+static inline void mousePoseInit(MousePose *pose, int row, int col, int heading)
+{
+    pose->row = row;
+    pose->col = col;
+    pose->heading = heading;
+    pose->pendingTurns = 0;
+    pose->pendingTurnIsLeft = 1;
+    pose->forwardNext = 0;
+}
+
+// The next action of a move in progress, or IDLE when there is none and
+// the mouse has to decide.
+static inline Action mouseContinueMove(MousePose *pose)
+{
+    if (pose->forwardNext)
+    {
+        pose->forwardNext = 0;
+        pose->row += dRow[pose->heading];
+        pose->col += dCol[pose->heading];
+        return FORWARD;
+    }
+    if (pose->pendingTurns > 0)
+    {
+        pose->pendingTurns--;
+        if (pose->pendingTurns == 0)
+            pose->forwardNext = 1;
+        pose->heading = (pose->heading + (pose->pendingTurnIsLeft ? 3 : 1)) % 4;
+        return pose->pendingTurnIsLeft ? LEFT : RIGHT;
+    }
+    return IDLE;
+}
+
+// Direction to move in, or -1 to stay. neighborDist[dir] is the distance of
+// the neighbor in dir, -1 when the edge is closed or the neighbor unreached.
+// Takes the open neighbor with the lowest distance below hereDist (any
+// reached one when hereDist is -1); directions are scanned from firstDir, so
+// the first one wins a tie. On an incomplete field a new wall may have cut
+// off every lower neighbor, so it takes the lowest open one rather than wait
+// for the flood to finish, and turns back only when nothing else is open:
+// going back tends to undo the previous fallback move and ping-pong until
+// the flood is done.
+static inline int mouseChooseDir(const int *neighborDist, int hereDist, int heading, int incomplete, int firstDir)
+{
+    int bestDir = -1;
+    int bestDist = incomplete && hereDist != 0 ? -1 : hereDist;
+    int backDir = -1;
+    for (int k = 0; k < 4; k++)
+    {
+        int dir = (firstDir + k) % 4;
+        int d = neighborDist[dir];
+        if (d < 0)
+            continue;
+        if (incomplete && dir == (heading + 2) % 4)
+        {
+            backDir = dir;
+            continue;
+        }
+        if (bestDist < 0 || d < bestDist)
+        {
+            bestDist = d;
+            bestDir = dir;
+        }
+    }
+    if (bestDir < 0 && backDir >= 0 && bestDist != 0)
+        bestDir = backDir;
+    return bestDir;
+}
+
+// Start the move to the neighbor in dir: FORWARD, a quarter turn (the next
+// step decides again) or the first left of a U-turn, which the following
+// mouseContinueMove() calls finish.
+static inline Action mouseStartMove(MousePose *pose, int dir)
+{
+    int turn = (dir - pose->heading + 4) % 4;
+    if (turn == 0)
+    {
+        pose->row += dRow[dir];
+        pose->col += dCol[dir];
+        return FORWARD;
+    }
+    if (turn == 1)
+    {
+        pose->heading = dir;
+        return RIGHT;
+    }
+    if (turn == 3)
+    {
+        pose->heading = dir;
+        return LEFT;
+    }
+    pose->pendingTurns = 1;
+    pose->pendingTurnIsLeft = 1;
+    pose->heading = (pose->heading + 3) % 4;
+    return LEFT;
+}
+
+#endif
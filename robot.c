@@ -0,0 +1,99 @@
+#include "robot.h"
+#include "flood.h"
+
+void robotInit(Robot *robot, int id, int row, int col, int heading)
+{
+    robot->id = id;
+    mousePoseInit(&robot->pose, row, col, heading);
+    robot->seenGeneration = ~0u; // no generation yet: the first step always floods
+    robot->steps = 0;
+    robot->floods = 0;
+}
+
+int robotAtGoal(const Robot *robot)
+{
+    int goal = GRID_SIZE / 2;
+    return (robot->pose.row == goal || robot->pose.row == goal - 1) &&
+           (robot->pose.col == goal || robot->pose.col == goal - 1);
+}
+
+void robotSense(Robot *robot, SharedMap *map, int wallFront, int wallRight, int wallLeft)
+{
+    if (wallFront)
+        sharedMapAddWall(map, robot->pose.row, robot->pose.col, robot->pose.heading);
+    if (wallRight)
+        sharedMapAddWall(map, robot->pose.row, robot->pose.col, (robot->pose.heading + 1) % 4);
+    if (wallLeft)
+        sharedMapAddWall(map, robot->pose.row, robot->pose.col, (robot->pose.heading + 3) % 4);
+}
+
+static void reflood(Robot *robot, SharedMap *map)
+{
+    unsigned int generation = sharedMapGeneration(map);
+    if (generation == robot->seenGeneration)
+        return;
+
+    int goals[4];
+    int goalCount = centerGoals(GRID_SIZE, GRID_SIZE, goals);
+    sharedMapSnapshot(map, robot->walls);
+    floodWalls(robot->walls, GRID_SIZE, GRID_SIZE, goals, goalCount, robot->distance, robot->queue);
+    robot->seenGeneration = generation;
+    robot->fieldStale = 0;
+    robot->floods++;
+}
+
+Action robotStep(Robot *robot, SharedMap *map)
+{
+    // finish a U-turn before anything else
+    Action act = mouseContinueMove(&robot->pose);
+    if (act != IDLE)
+    {
+        robot->steps++;
+        return act;
+    }
+
+    if (robotAtGoal(robot))
+        return IDLE;
+
+    reflood(robot, map);
+
+    // The snapshot may predate a wall around us: one this robot just sensed
+    // that another robot published first (no generation bump for us), or one
+    // whose generation bump has not landed yet. Take the live walls of this
+    // cell and its neighbors before choosing a move; a wall the flood did
+    // not see makes the field incomplete, as a stale field is for solver().
+    int row = robot->pose.row;
+    int col = robot->pose.col;
+    int here = row * GRID_SIZE + col;
+    unsigned char before = robot->walls[here];
+    robot->walls[here] |= sharedMapWalls(map, here);
+    robot->fieldStale |= robot->walls[here] != before;
+    for (int dir = 0; dir < 4; dir++)
+    {
+        int nr = row + dRow[dir];
+        int nc = col + dCol[dir];
+        if (nr < 0 || nr >= GRID_SIZE || nc < 0 || nc >= GRID_SIZE)
+            continue;
+        int cell = nr * GRID_SIZE + nc;
+        before = robot->walls[cell];
+        robot->walls[cell] |= sharedMapWalls(map, cell);
+        robot->fieldStale |= robot->walls[cell] != before;
+    }
+
+    // each robot starts its scan at a different heading so ties split the
+    // team instead of sending everyone the same way
+    int neighborDist[4];
+    for (int dir = 0; dir < 4; dir++)
+    {
+        neighborDist[dir] = -1;
+        if (wallsOpen(robot->walls, GRID_SIZE, GRID_SIZE, here, dir))
+            neighborDist[dir] = robot->distance[here + dRow[dir] * GRID_SIZE + dCol[dir]];
+    }
+    int bestDir = mouseChooseDir(neighborDist, robot->distance[here], robot->pose.heading, robot->fieldStale,
+                                 robot->id % 4);
+    if (bestDir < 0)
+        return IDLE;
+
+    robot->steps++;
+    return mouseStartMove(&robot->pose, bestDir);
+}
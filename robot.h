@@ -0,0 +1,36 @@
+#ifndef ROBOT_H
+#define ROBOT_H
+
+#include "mouse.h"
+#include "sharedmap.h"
+
+// One mouse of a team exploring a SharedMap. Every robot owns its position,
+// heading and distance field; only the walls are shared. A robot refloods
+// only when the map generation has moved since its last flood, and moves
+// with the decision step solver() uses (mouse.h).
+
+typedef struct Robot
+{
+    int id;
+    MousePose pose;
+    unsigned int seenGeneration; // map generation of the current distance field
+    long steps;                  // actions taken (moves and turns)
+    long floods;
+    unsigned char walls[GRID_SIZE * GRID_SIZE]; // snapshot the distance field was built from
+    int fieldStale;                             // walls have been added to the snapshot since
+    int distance[GRID_SIZE * GRID_SIZE];
+    int queue[GRID_SIZE * GRID_SIZE];
+} Robot;
+
+void robotInit(Robot *robot, int id, int row, int col, int heading);
+
+// Publish what the sensors see from the current cell (1 = wall).
+void robotSense(Robot *robot, SharedMap *map, int wallFront, int wallRight, int wallLeft);
+
+// Choose and apply one action towards the goal with solver()'s decision
+// step. Returns IDLE on the goal or when no route is known.
+Action robotStep(Robot *robot, SharedMap *map);
+
+int robotAtGoal(const Robot *robot);
+
+#endif
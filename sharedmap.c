@@ -0,0 +1,61 @@
+#include "sharedmap.h"
+
+void sharedMapInit(SharedMap *map)
+{
+    for (int r = 0; r < GRID_SIZE; r++)
+    {
+        for (int c = 0; c < GRID_SIZE; c++)
+        {
+            unsigned char walls = 0;
+            if (r == 0)
+                walls |= WALL_N;
+            if (r == GRID_SIZE - 1)
+                walls |= WALL_S;
+            if (c == 0)
+                walls |= WALL_W;
+            if (c == GRID_SIZE - 1)
+                walls |= WALL_E;
+            atomic_init(&map->walls[r * GRID_SIZE + c], walls);
+        }
+    }
+    atomic_init(&map->generation, 0);
+}
+
+int sharedMapAddWall(SharedMap *map, int r, int c, int dir)
+{
+    unsigned char mask = dirMask[dir];
+
+    // cheap check first: most sensor readings repeat known walls
+    if (atomic_load_explicit(&map->walls[r * GRID_SIZE + c], memory_order_relaxed) & mask)
+        return 0;
+
+    unsigned char before = atomic_fetch_or_explicit(&map->walls[r * GRID_SIZE + c], mask, memory_order_relaxed);
+
+    int nr = r + dRow[dir];
+    int nc = c + dCol[dir];
+    if (nr >= 0 && nr < GRID_SIZE && nc >= 0 && nc < GRID_SIZE)
+        atomic_fetch_or_explicit(&map->walls[nr * GRID_SIZE + nc], dirMask[(dir + 2) % 4], memory_order_relaxed);
+
+    if (before & mask)
+        return 0; // another robot got there first
+
+    // release: a reader that sees the new generation also sees the wall
+    atomic_fetch_add_explicit(&map->generation, 1, memory_order_release);
+    return 1;
+}
+
+unsigned int sharedMapGeneration(SharedMap *map)
+{
+    return atomic_load_explicit(&map->generation, memory_order_acquire);
+}
+
+unsigned char sharedMapWalls(SharedMap *map, int cell)
+{
+    return atomic_load_explicit(&map->walls[cell], memory_order_relaxed);
+}
+
+void sharedMapSnapshot(SharedMap *map, unsigned char *walls)
+{
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++)
+        walls[i] = atomic_load_explicit(&map->walls[i], memory_order_relaxed);
+}
@@ -0,0 +1,36 @@
+#ifndef SHAREDMAP_H
+#define SHAREDMAP_H
+
+#include <stdatomic.h>
+#include "solver.h"
+
+// Wall map shared by several robots exploring the same maze.
+//
+// Walls are only ever added, never removed, so every update is a single
+// atomic OR into the cell's bitmask: no locks, and a reader can never see a
+// wall disappear. Each update that adds a new bit bumps the generation
+// counter, which lets a robot skip its reflood when nothing has changed.
+
+typedef struct SharedMap
+{
+    _Atomic unsigned char walls[GRID_SIZE * GRID_SIZE]; // WALL_* bitmasks, row-major
+    _Atomic unsigned int generation;
+} SharedMap;
+
+// Clear the map and set the outer walls.
+void sharedMapInit(SharedMap *map);
+
+// Add the wall on side dir of (r, c) and its twin on the neighbor.
+// Returns 1 if the wall was new.
+int sharedMapAddWall(SharedMap *map, int r, int c, int dir);
+
+unsigned int sharedMapGeneration(SharedMap *map);
+
+// Current walls of one cell (row-major index), including any added after the
+// last generation a reader saw.
+unsigned char sharedMapWalls(SharedMap *map, int cell);
+
+// Copy the current walls into a plain array (GRID_SIZE * GRID_SIZE bytes).
+void sharedMapSnapshot(SharedMap *map, unsigned char *walls);
+
+#endif
@@ -1,53 +1,95 @@
 #include "solver.h"
 #include "API.h"
-#include <stdio.h>
-#include <stdlib.h>
-
-#define GRID_SIZE 16
-#define QUEUE_CAPACITY (GRID_SIZE * GRID_SIZE)
-// add heading n e s w as 0 1 2 3
-#define NORTH 0
-#define EAST 1
-#define SOUTH 2
-#define WEST 3
-
-// the grid
-#define WALL_N 1 // 0001
-#define WALL_E 2 // 0010
-#define WALL_S 4 // 0100
-#define WALL_W 8 // 1000
-
-// a small state machine to handle multi-turn moves:
-// --- State for multi-turn handling (replace the previous forwardNext static) ---
-// pendingTurns = how many 90-degree turns still need to be executed before the final FORWARD
-static int pendingTurns = 0;
-// pendingTurnIsLeft: 1 => turn left each pending turn, 0 => turn right each pending turn
-static int pendingTurnIsLeft = 1;
-// once pendingTurns reaches 0 we set forwardNext=1 so next call does forward
-static int forwardNext = 0;
-
-// Movement
-int dRow[4] = {-1, 0, 1, 0}; // WALL_N, WALL_E, WALL_S, WALL_W
-int dCol[4] = {0, 1, 0, -1};
-int dirMask[4] = {WALL_N, WALL_E, WALL_S, WALL_W}; // 0:N, 1:E, 2:S, 3:W bitmasks
+#include "mouse.h"
+#include <stddef.h>
+#ifdef USE_HPA
+#include "hpa.h"
+#endif
+
+// GRID_SIZE, headings (n e s w as 0 1 2 3) and the WALL_* bitmasks come from solver.h
 
 Cell maze[GRID_SIZE][GRID_SIZE];
 
+// Distance fields live outside the maze cells
+#if GRID_SIZE * GRID_SIZE <= 32768
+typedef short FieldDistance;
+#else
+typedef int FieldDistance;
+#endif
+#define FIELD_CELLS (GRID_SIZE * GRID_SIZE)
+
+// Field buffers. Fields are never copied: the published field, the cached
+// ones and the flood in progress are pointers into this pool, and finishing
+// a flood or hitting the cache only moves pointers. Enough buffers for every
+// cache slot, a published field that is not cached and the work field.
+#define FIELD_BUFFERS (FLOOD_CACHE_SIZE + 2)
+
+// Cached distance fields, least recently used first out
+typedef struct
+{
+    unsigned long long hash;
+    unsigned long lastUsed;  // 0 = empty slot
+    FieldDistance *distance; // one of the field buffers
+} FloodCacheEntry;
+
+// Everything solver.c keeps between calls besides the maze and solverStatus,
+// in one place so that sizeof() can account for it.
+static struct
+{
+    int initialized;
+
+    // solver()'s position, heading and the rest of a U-turn
+    MousePose pose;
+
+    // Anytime flood: the flood in progress fills floodWork, starting with a
+    // budgeted clear of the buffer, and becomes the published field only
+    // once it has finished
+    FieldDistance fieldBuffers[FIELD_BUFFERS][FIELD_CELLS];
+    FieldDistance *floodWork;
+    FieldDistance *field; // last complete field, NULL = none yet
+    Queue floodQueue;     // kept for the whole run: the flood may span calls
+    int floodActive;
+    int floodCleared;             // cells of floodWork reset so far
+    unsigned long long floodHash; // walls the running flood started from
+    int floodLevel;               // distance of the last cell it expanded
+    unsigned long long fieldHash; // walls the published field was flooded from
+
+#if FLOOD_CACHE_SIZE > 0
+    FloodCacheEntry floodCache[FLOOD_CACHE_SIZE];
+#endif
+    unsigned long floodCacheClock;
+} state = {
+    .pose = {.row = GRID_SIZE - 1, .col = 0, .heading = NORTH, .pendingTurnIsLeft = 1}, // start facing North
+};
+
+SolverStatus solverStatus = {.floodBudget = FLOOD_BUDGET};
+
+#define SOLVER_RAM_BYTES (sizeof(maze) + sizeof(state) + sizeof(solverStatus))
+const unsigned long solverRamBytes = SOLVER_RAM_BYTES;
+const unsigned long floodCacheBytes = FLOOD_CACHE_SIZE * (sizeof(FloodCacheEntry) + sizeof(state.fieldBuffers[0]));
+
+#ifdef MAZE_EMBEDDED
+_Static_assert(SOLVER_RAM_BYTES <= MAZE_RAM_BUDGET, "solver state does not fit in MAZE_RAM_BUDGET");
+#ifdef USE_HPA
+#error "the embedded profile runs the plain flood fill; HPA is meant for large host mazes"
+#endif
+#endif
+
 // some helper functions
+int cellDistance(int r, int c)
+{
+    return state.field ? state.field[r * GRID_SIZE + c] : -1;
+}
+
 int isBlank(Cell *cell)
 {
-    return cell->distance == -1; // Assuming -1 indicates blank
+    return cellDistance(cell->row, cell->col) == -1; // -1 indicates blank
 }
 
+// forget the published field; the next floodFill() builds a new one
 void resetDistances()
 {
-    for (int r = 0; r < GRID_SIZE; r++)
-    {
-        for (int c = 0; c < GRID_SIZE; c++)
-        {
-            maze[r][c].distance = -1;
-        }
-    }
+    state.field = NULL;
 }
 
 void setOuterWalls() /// if you reverse the array to standard like it need to modifiy here
@@ -70,6 +112,28 @@ void setOuterWalls() /// if you reverse the array to standard like it need to mo
     debug_log("Outer walls completed\n");
 }
 
+// Key of one wall bit. Keys are computed (a splitmix64 finalizer of the bit
+// index) rather than stored: a table of GRID_SIZE^2 * 4 keys would not fit
+// the embedded budget.
+static unsigned long long zobristKey(int r, int c, int dir)
+{
+    unsigned long long z = ((unsigned long long)((r * GRID_SIZE + c) * 4 + dir) + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static unsigned long long cellHash(int r, int c, unsigned int walls)
+{
+    unsigned long long h = 0;
+    for (int dir = 0; dir < 4; dir++)
+    {
+        if (walls & dirMask[dir])
+            h ^= zobristKey(r, c, dir);
+    }
+    return h;
+}
+
 void initSet()
 {
     debug_log("Starting initSet()...\n");
@@ -78,7 +142,6 @@ void initSet()
         for (int c = 0; c < GRID_SIZE; c++)
         {
             maze[r][c].walls = 0; // No walls known
-            maze[r][c].distance = -1;
             maze[r][c].row = r;
             maze[r][c].col = c;
         }
@@ -89,6 +152,18 @@ void initSet()
     setOuterWalls();
     debug_log("Outer walls set, setting start position walls...\n");
 
+    // no field yet, and any unfinished flood belonged to the old maze
+    state.floodActive = 0;
+    resetDistances();
+
+    // start the hash over from the walls we know now
+    solverStatus.wallHash = 0;
+    for (int r = 0; r < GRID_SIZE; r++)
+    {
+        for (int c = 0; c < GRID_SIZE; c++)
+            solverStatus.wallHash ^= cellHash(r, c, maze[r][c].walls);
+    }
+
     debug_log("initSet() completed\n");
 }
 
@@ -108,6 +183,14 @@ void addWall(int r, int c, int dir)
         debug_log("Error in addWall: invalid direction");
     }
 
+#ifdef USE_HPA
+    // only a wall we did not know about changes the cluster graph
+    int isNewWall = (walls != 0) && !(maze[r][c].walls & walls);
+    if (isNewWall)
+        hpaInvalidate(r, c);
+#endif
+
+    solverStatus.wallHash ^= cellHash(r, c, walls & ~maze[r][c].walls);
     maze[r][c].walls |= walls;
 
     // Update the neighbor in the opposite direction
@@ -123,6 +206,7 @@ void addWall(int r, int c, int dir)
 
     if (nr >= 0 && nr < GRID_SIZE && nc >= 0 && nc < GRID_SIZE)
     {
+        unsigned int before = maze[nr][nc].walls;
         if (dir == NORTH)
             maze[nr][nc].walls |= WALL_S;
         if (dir == SOUTH)
@@ -131,6 +215,12 @@ void addWall(int r, int c, int dir)
             maze[nr][nc].walls |= WALL_E;
         if (dir == EAST)
             maze[nr][nc].walls |= WALL_W;
+        solverStatus.wallHash ^= cellHash(nr, nc, maze[nr][nc].walls & ~before);
+#ifdef USE_HPA
+        // a wall on a cluster border also changes the cluster on the other side
+        if (isNewWall)
+            hpaInvalidate(nr, nc);
+#endif
     }
 
     if (maze[r][c].walls & WALL_N)
@@ -174,67 +264,12 @@ int turnRightDir(int heading)
     return heading; // should not happen
 }
 
-// planMove: decide how to move from (row,col) facing *dir* towards (targetRow,targetCol).
-// dir is passed by pointer so we can update it if needed.
-Action planMove(int row, int col, int targetRow, int targetCol, int *heading)
+// Queues are static (no heap): floodFill() keeps its one queue in the
+// solver state and empties it here for every new flood.
+void initQueue(Queue *queue)
 {
-    // Determine which direction target cell lies in
-    // heading missing with dir walls
-    int desiredHeading;
-
-    if (targetRow == row - 1 && targetCol == col) // move upward
-        desiredHeading = NORTH;
-    else if (targetRow == row + 1 && targetCol == col) // move downward
-        desiredHeading = SOUTH;
-    else if (targetRow == row && targetCol == col + 1) // move right
-        desiredHeading = EAST;
-    else if (targetRow == row && targetCol == col - 1) // move left
-        desiredHeading = WEST;
-    else
-    {
-        // here the debug_log doesn't do anything because it is a simulation so I replaced it with a debug_log down here
-        // char buf[128];
-        // debug_log(buf, sizeof(buf),
-        //           "DEBUG: row=%d col=%d heading=%d targetRow=%d targetCol=%d",
-        //           row, col, *heading, targetRow, targetCol);
-        // debug_log(buf);
-
-        debug_log("return next move IDLE");
-        return IDLE; // Not a valid neighbor
-    }
-
-    // If already facing the right direction → move forward
-    if (*heading == desiredHeading)
-        return FORWARD;
-
-    // Check if turning left gets us there
-    else if (turnLeftDir(*heading) == desiredHeading)
-        return LEFT;
-
-    // Check if turning right gets us there
-    else if (turnRightDir(*heading) == desiredHeading)
-        return RIGHT;
-    // else if (turnLeftDir(turnLeftDir(*heading)) == desiredHeading) // untageld
-    //     return pending = 2;
-    else
-    {
-        // Otherwise it's the opposite direction.
-        // We'll plan two left turns (could pick right; they both take 2 turns).
-        // Set pendingTurns so solver will perform two turns across successive solver() calls,
-        // then set forwardNext so the following call will move forward.
-        pendingTurns = 2;
-        pendingTurnIsLeft = 1; // use left turns for the 180°
-        // Return one left now — solver() will execute one left turn immediately.
-        return LEFT;
-    }
-}
-
-Queue *createQueue()
-{
-    Queue *queue = (Queue *)malloc(sizeof(Queue));
     queue->front = 0;
     queue->size = 0;
-    return queue;
 }
 
 Cell *getRear(Queue *queue)
@@ -279,110 +314,153 @@ Cell *dequeue(Queue *queue)
 
 // detect walls → update maze → re-flood → pick loWALL_W-distance neighbor → move
 
-static int initialized = 0;
+#ifndef USE_HPA
+// Distance the move decision uses: the unfinished flood once it has reached
+// the mouse (BFS has settled every cell closer to the goal by then),
+// otherwise the last complete field.
+static int plannedDistance(int useWork, int r, int c)
+{
+    return useWork ? state.floodWork[r * GRID_SIZE + c] : cellDistance(r, c);
+}
 
-Action solver()
+// Whether the running flood may already have expanded cell (r, c), and so
+// read its walls. The flood expands cells in order of distance: none before
+// the work field is cleared, and none farther than the last one expanded.
+static int floodMayHaveExpanded(int r, int c)
 {
-    // starting row and column & direction:
-    // static as local for just inside this function
-    // initialize only once
-    static int row = GRID_SIZE - 1;
-    static int col = 0;
-    // Heading missid with wall directions dir
-    static int heading = NORTH; // start facing North
+    if (state.floodCleared < FIELD_CELLS)
+        return 0;
+    int d = state.floodWork[r * GRID_SIZE + c];
+    return d >= 0 && d <= state.floodLevel;
+}
 
+// Whether the running flood has read an edge of (r, c) that now has a wall.
+static int floodSawWalls(int r, int c)
+{
+    if (floodMayHaveExpanded(r, c))
+        return 1;
+    for (int i = 0; i < 4; i++)
+    {
+        int nr = r + dRow[i], nc = c + dCol[i];
+        if ((maze[r][c].walls & dirMask[i]) && nr >= 0 && nr < GRID_SIZE && nc >= 0 && nc < GRID_SIZE &&
+            floodMayHaveExpanded(nr, nc))
+            return 1;
+    }
+    return 0;
+}
+#endif
+
+Action solver()
+{
     // for checking:
     // return leftWallFollower();
 
-    // if we should immediately move forward (after finishing turns)
-    if (forwardNext)
+    // Reset by the simulator: the mouse is back on the start cell facing
+    // north. Start over with no walls below; the flood cache is kept, so
+    // wall sets the last run already flooded are looked up, not flooded.
+    if (API_wasReset())
     {
-        forwardNext = 0;
-        debug_log("Executing pending FORWARD\n");
-
-        // advance position according to heading
-        row += dRow[heading];
-        col += dCol[heading];
-
-        return FORWARD;
+        debug_log("Reset: back to the start\n");
+        mousePoseInit(&state.pose, GRID_SIZE - 1, 0, NORTH);
+        state.initialized = 0;
+        API_ackReset();
     }
 
-    // If there are pending turns, perform one turn now (do not prematurely FORWARD)
-    if (pendingTurns > 0)
+    // finish a U-turn before sensing again: the second left, then FORWARD
+    Action pending = mouseContinueMove(&state.pose);
+    if (pending != IDLE)
     {
-        if (pendingTurnIsLeft)
-        {
-            // perform one left turn
-            pendingTurns--;
-            // update our internal direction to reflect the turn
-            // NOTE: dir must be accessible; we'll declare dir static below if not already
-            // We'll update dir here (see static dir declaration below)
-            // Return LEFT action so caller will execute one 90° left turn physically.
-            if (pendingTurns == 0)
-                forwardNext = 1; // after this turn sequence, next call should go forward
-            heading = turnLeftDir(heading);
-            return LEFT;
-        }
-        else
-        {
-            pendingTurns--;
-            if (pendingTurns == 0)
-                forwardNext = 1;
-            heading = turnRightDir(heading);
-            return RIGHT;
-        }
+        debug_log("Executing pending move\n");
+        return pending;
     }
 
-    if (!initialized)
+    if (!state.initialized)
     {
         // 1-> Set all cells except goal to “blank state”:
         initSet();
-        floodFill();
-        initialized = 1;
+#ifdef USE_HPA
+        hpaInit();
+#endif
+        // without HPA the first flood runs below, within the step's budget
+        state.initialized = 1;
         debug_log("Init...");
     }
 
-    int wallsChanged = 0;
-
-    // Check walls around and update maze
+    // Check walls around and update maze. Most readings repeat walls we
+    // already know; only a new one changes the hash.
+    unsigned long long hashBefore = solverStatus.wallHash;
     if (API_wallFront())
     {
-        addWall(row, col, heading);
+        addWall(state.pose.row, state.pose.col, state.pose.heading);
         debug_log("wallFront...");
-        wallsChanged = 1;
     }
 
     if (API_wallLeft())
     {
-        addWall(row, col, turnLeftDir(heading));
+        addWall(state.pose.row, state.pose.col, turnLeftDir(state.pose.heading));
         debug_log("wall left...");
-        wallsChanged = 1;
     }
 
     if (API_wallRight())
     {
-        addWall(row, col, turnRightDir(heading));
+        addWall(state.pose.row, state.pose.col, turnRightDir(state.pose.heading));
         debug_log("wall right...");
-        wallsChanged = 1;
     }
-
-    // If walls changed -> reflood
-    if (wallsChanged)
+    int wallsChanged = solverStatus.wallHash != hashBefore;
+
+#ifdef USE_HPA
+    // The hierarchical planner rebuilds only the clusters addWall() invalidated,
+    // so there is no full reflood here.
+    (void)wallsChanged;
+    int bestRow = state.pose.row, bestCol = state.pose.col;
+    hpaNextCell(state.pose.row, state.pose.col, &bestRow, &bestCol);
+    int bestDir = -1;
+    for (int i = 0; i < 4; i++)
+    {
+        if (bestRow == state.pose.row + dRow[i] && bestCol == state.pose.col + dCol[i])
+            bestDir = i;
+    }
+#else
+    // If walls changed, or the last flood is unfinished or stale -> reflood.
+    // The unfinished flood reads maze[] as it goes, so new walls between
+    // cells it has not expanded yet leave it exact: it carries on with them.
+    // New walls it has already read past make it stale, and then it starts
+    // over rather than finishing first: a flood of the current walls is
+    // exact at the mouse as soon as it has expanded the cells closer to the
+    // goal, well before a stale flood and its redo are both done.
+    if (wallsChanged && state.floodActive)
+    {
+        if (state.floodHash == hashBefore && !floodSawWalls(state.pose.row, state.pose.col))
+            state.floodHash = solverStatus.wallHash;
+        else
+            state.floodActive = 0;
+    }
+    if (wallsChanged || state.floodActive || !state.field || state.fieldHash != solverStatus.wallHash)
     {
         floodFill();
         debug_log("wall changed -> reFlooded...");
     }
 
-    // ADD DEBUG OUTPUT HERE
-
-    // Choose next move = neighbor with lowest distance
-    int bestRow = row, bestCol = col;
-    int bestDist = maze[row][col].distance;
+    // An unfinished flood of the current walls that has reached the mouse
+    // already gives the exact move; otherwise decide on the last complete
+    // field and say so.
+    int useWork = state.floodActive && state.floodHash == solverStatus.wallHash && state.floodCleared == FIELD_CELLS &&
+                  state.floodWork[state.pose.row * GRID_SIZE + state.pose.col] >= 0;
+    solverStatus.decisionIncomplete = !useWork && (state.floodActive || state.fieldHash != solverStatus.wallHash);
+    if (solverStatus.decisionIncomplete)
+    {
+        solverStatus.incompleteDecisions++;
+        debug_log("deciding on an incomplete flood...");
+    }
 
+    // Choose next move = neighbor with lowest distance (mouse.h, shared with
+    // the robots of robot.c)
+    int neighborDist[4];
     for (int i = 0; i < 4; i++)
     {
-        int nx = row + dRow[i];
-        int ny = col + dCol[i];
+        int nx = state.pose.row + dRow[i];
+        int ny = state.pose.col + dCol[i];
+        neighborDist[i] = -1;
 
         // Check bounds
         if (nx < 0 || nx >= GRID_SIZE || ny < 0 || ny >= GRID_SIZE)
@@ -390,27 +468,20 @@ Action solver()
 
         // Check accessible
         int opposite = (i + 2) % 4;
-        if ((maze[row][col].walls & dirMask[i]) ||
+        if ((maze[state.pose.row][state.pose.col].walls & dirMask[i]) ||
             (maze[nx][ny].walls & dirMask[opposite]))
         {
             debug_log("NOT accessible\n");
             continue;
         }
-        else
-        {
-            if (maze[nx][ny].distance < bestDist)
-            {
-                bestDist = maze[nx][ny].distance;
-                bestRow = nx;
-                bestCol = ny;
-                debug_log("found next cell...");
-            }
-            debug_log("\n");
-        }
+        neighborDist[i] = plannedDistance(useWork, nx, ny);
     }
+    int bestDir = mouseChooseDir(neighborDist, plannedDistance(useWork, state.pose.row, state.pose.col),
+                                 state.pose.heading, solverStatus.decisionIncomplete, NORTH);
+#endif
 
-    // now  plan the move to (bestRow, bestCol)
-    Action act = planMove(row, col, bestRow, bestCol, &heading);
+    // now start the move towards bestDir
+    Action act = bestDir < 0 ? IDLE : mouseStartMove(&state.pose, bestDir);
     debug_log("paln next move...");
     debug_log("Action decided is: ");
 
@@ -421,29 +492,7 @@ Action solver()
     else if (act == RIGHT)
         debug_log("RIGHT\n");
     else
-        debug_log("IDLE\n");
-
-    // update our internal state after movement
-    if (act == FORWARD)
-    {
-        row = bestRow;
-        col = bestCol;
-    }
-    else if (act == LEFT)
-    {
-        // perform single left turn now (the physical turn will be executed by caller)
-
-        heading = turnLeftDir(heading);
-    }
-    else if (act == RIGHT)
-    {
-        heading = turnRightDir(heading);
-    }
-    else
-    {
         debug_log("Action: IDLE - This shouldn't happen!\n");
-    }
-    debug_log("update state ,,...");
 
     return act;
 }
@@ -462,59 +511,178 @@ Action leftWallFollower()
     return FORWARD;
 }
 
-// Put your implementation of floodfill here!
-void floodFill()
+#ifndef MAZE_NO_DISPLAY
+// decimal text for API_setText without pulling in stdio
+static void formatInt(int value, char *text)
 {
-    debug_log("Starting floodFill()...\n"); // form # here is correct to
-    // reset only distances, keep walls
-    resetDistances();
-    debug_log("Distances reset\n");
-    Queue *queue = createQueue(); // to # here
+    char digits[11];
+    int n = 0;
+    unsigned int v = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do
+    {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    if (value < 0)
+        *text++ = '-';
+    while (n)
+        *text++ = digits[--n];
+    *text = '\0';
+}
+#endif
 
-    // Set goal cell(s) value to 0 and add to queue:
-    int goal = GRID_SIZE / 2;
+void floodCacheReset()
+{
+#if FLOOD_CACHE_SIZE > 0
+    for (int i = 0; i < FLOOD_CACHE_SIZE; i++)
+        state.floodCache[i].lastUsed = 0;
+#endif
+    state.floodCacheClock = 0;
+    solverStatus.floodCacheHits = 0;
+    solverStatus.floodCacheMisses = 0;
+}
 
-    maze[goal][goal].distance = 0;
-    maze[goal - 1][goal].distance = 0;
-    maze[goal][goal - 1].distance = 0;
-    maze[goal - 1][goal - 1].distance = 0;
-    debug_log("Goal distances set to 0\n");
+// A buffer that neither the published field nor the cache refers to.
+static FieldDistance *freeFieldBuffer()
+{
+    unsigned char used[FIELD_BUFFERS] = {0};
+    if (state.field)
+        used[(state.field - state.fieldBuffers[0]) / FIELD_CELLS] = 1;
+#if FLOOD_CACHE_SIZE > 0
+    for (int i = 0; i < FLOOD_CACHE_SIZE; i++)
+    {
+        if (state.floodCache[i].lastUsed != 0)
+            used[(state.floodCache[i].distance - state.fieldBuffers[0]) / FIELD_CELLS] = 1;
+    }
+#endif
+    for (int b = 0; b < FIELD_BUFFERS; b++)
+    {
+        if (!used[b])
+            return state.fieldBuffers[b];
+    }
+    return NULL; // cannot happen: there is one buffer more than can be in use
+}
 
-    if (!queue)
+#if FLOOD_CACHE_SIZE > 0
+// Publish the field flooded for the current walls if it is cached.
+// Returns 0 when it is not. The simulator's distance text is left as it is.
+static int floodCacheLoad()
+{
+    for (int i = 0; i < FLOOD_CACHE_SIZE; i++)
     {
-        debug_log("ERROR: Failed to create queue!\n");
-        return;
+        FloodCacheEntry *entry = &state.floodCache[i];
+        if (entry->lastUsed == 0 || entry->hash != solverStatus.wallHash)
+            continue;
+
+        entry->lastUsed = ++state.floodCacheClock;
+        solverStatus.floodCacheHits++;
+        state.field = entry->distance;
+        return 1;
+    }
+    solverStatus.floodCacheMisses++;
+    return 0;
+}
+
+// Keep the field just published, evicting the least recently used one.
+static void floodCacheStore()
+{
+    FloodCacheEntry *victim = &state.floodCache[0];
+    for (int i = 1; i < FLOOD_CACHE_SIZE; i++)
+    {
+        if (state.floodCache[i].lastUsed < victim->lastUsed)
+            victim = &state.floodCache[i];
     }
-    debug_log("Queue created\n");
 
-    enqueue(queue, &maze[goal][goal]); // Add goal cell's info to queue
-    enqueue(queue, &maze[goal - 1][goal]);
-    enqueue(queue, &maze[goal][goal - 1]);
-    enqueue(queue, &maze[goal - 1][goal - 1]);
+    victim->hash = state.fieldHash;
+    victim->lastUsed = ++state.floodCacheClock;
+    victim->distance = state.field;
+}
+#endif
 
-    int iterations = 0;
-    // While queue is not empty:
-    while (queue->size > 0)
+// Queue the goal cells for a new flood into a free buffer; the buffer is
+// cleared by the first slices of the flood.
+static int startFlood()
+{
+    debug_log("Starting floodFill()...\n");
+    initQueue(&state.floodQueue);
+
+    state.floodWork = freeFieldBuffer();
+    state.floodCleared = 0;
+    state.floodHash = solverStatus.wallHash;
+    state.floodLevel = -1;
+    state.floodActive = 1;
+    return 1;
+}
+
+// Put your implementation of floodfill here!
+// One slice of the flood: does at most floodBudget units of work (all of it
+// when floodBudget is 0) and continues the unfinished flood from the previous
+// call, if any. A unit is one cell expanded (a dequeue and 4 neighbor checks)
+// or FLOOD_CLEAR_CELLS cells of the work field reset; everything else is
+// O(1) or O(FLOOD_CACHE_SIZE), so no call does more than about floodBudget
+// units. floodWorkDone reports the units the call spent.
+// Walls added meanwhile are honoured from then on; a flood that saw them
+// arrive is published but flooded again on the next call. solver() does not
+// leave it to that: it restarts a flood that new walls have made stale.
+int floodFill()
+{
+    solverStatus.floodWorkDone = 0;
+    if (!state.floodActive)
     {
-        iterations++;
-        if (iterations > GRID_SIZE * GRID_SIZE * 2)
+#if FLOOD_CACHE_SIZE > 0
+        // same walls as an earlier flood: same distances
+        if (floodCacheLoad())
         {
-            debug_log("ERROR: Too many iterations in floodFill! Breaking to avoid infinite loop.\n");
-            break;
+            state.fieldHash = solverStatus.wallHash;
+            return 1;
         }
+#else
+        solverStatus.floodCacheMisses++; // every flood is a miss
+#endif
+        if (!startFlood())
+            return 0;
+    }
+
+    // reset the work field a few cells per unit
+    while (state.floodCleared < FIELD_CELLS)
+    {
+        if (solverStatus.floodBudget > 0 && solverStatus.floodWorkDone == solverStatus.floodBudget)
+            return 0; // out of budget: resume here on the next call
+        solverStatus.floodWorkDone++;
+        for (int n = 0; n < FLOOD_CLEAR_CELLS && state.floodCleared < FIELD_CELLS; n++)
+            state.floodWork[state.floodCleared++] = -1;
 
-        if (iterations % 50 == 0)
+        if (state.floodCleared == FIELD_CELLS)
         {
-            debug_log("floodFill iteration  mod50 == 0...\n");
+            // Set goal cell(s) value to 0 and add to queue:
+            int goal = GRID_SIZE / 2;
+            for (int r = goal - 1; r <= goal; r++)
+            {
+                for (int c = goal - 1; c <= goal; c++)
+                {
+                    state.floodWork[r * GRID_SIZE + c] = 0;
+                    enqueue(&state.floodQueue, &maze[r][c]);
+                }
+            }
         }
+    }
+
+    // While queue is not empty:
+    while (state.floodQueue.size > 0)
+    {
+        if (solverStatus.floodBudget > 0 && solverStatus.floodWorkDone == solverStatus.floodBudget)
+            return 0; // out of budget: resume here on the next call
+        solverStatus.floodWorkDone++;
 
         // i- Take front cell in queue “out of line” for consideration:
-        Cell *current = dequeue(queue);
+        Cell *current = dequeue(&state.floodQueue);
         if (!current)
         {
             debug_log("ERROR: dequeue returned NULL!\n");
             break;
         }
+        int here = state.floodWork[current->row * GRID_SIZE + current->col];
+        state.floodLevel = here;
 
         API_clearText(current->row, current->col); // clear previous text
 
@@ -537,17 +705,29 @@ void floodFill()
             }
 
             // check if nieghbor is blank (unvisited)
-            if (isBlank(&maze[nr][nc]))
+            if (state.floodWork[nr * GRID_SIZE + nc] == -1)
             {
-                maze[nr][nc].distance = current->distance + 1;
-                API_setText(nr, nc, maze[nr][nc].distance); // for debugging in simulator
+                state.floodWork[nr * GRID_SIZE + nc] = here + 1;
+#ifndef MAZE_NO_DISPLAY
+                char text[12];
+                formatInt(here + 1, text);
+                API_setText(nr, nc, text); // for debugging in simulator
+#endif
                 // Add neighbor to queue
-                enqueue(queue, &maze[nr][nc]);
+                enqueue(&state.floodQueue, &maze[nr][nc]);
             }
         }
     } // iv- Else, continue!:
 
-    free(queue);
-
-    // return IDLE;
-}
\ No newline at end of file
+    // finished: this is now the last complete field
+    state.field = state.floodWork;
+    state.floodWork = NULL;
+    state.floodActive = 0;
+    state.fieldHash = state.floodHash;
+
+#if FLOOD_CACHE_SIZE > 0
+    if (state.fieldHash == solverStatus.wallHash)
+        floodCacheStore();
+#endif
+    return state.fieldHash == solverStatus.wallHash;
+}
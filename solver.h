@@ -25,9 +25,60 @@
 #ifndef SOLVER_H
 #define SOLVER_H
 
-#define GRID_SIZE 16
+#ifndef GRID_SIZE
+#define GRID_SIZE 16 // override with -DGRID_SIZE=256 for large generated mazes
+#endif
 #define QUEUE_CAPACITY (GRID_SIZE * GRID_SIZE)
 
+// Embedded profile (-DMAZE_EMBEDDED): no heap, no stdio, and every byte of
+// solver state is static and checked against MAZE_RAM_BUDGET at compile time.
+//   RAM   = GRID_SIZE^2 * (sizeof(Cell) + sizeof(Cell *)) + state
+//           + (FLOOD_CACHE_SIZE + 2) * GRID_SIZE^2 * 2 for the distance
+//           fields: the cached ones, the published one and the work field
+//           (16x16 with no cache: 6288 bytes with 64-bit pointers, 5232
+//           with 32-bit ones)
+//   flood = GRID_SIZE^2 / FLOOD_CLEAR_CELLS units to clear the work field,
+//           then one unit (a dequeue and 4 neighbor checks) per reachable
+//           cell; the worst case is the open grid
+//           (16x16: 16 + 256 = 272 units; measured on an x86-64 host at
+//           about 31 TSC cycles per unit, 8.4k cycles for the whole flood,
+//           12.5k median. Scale by the clock ratio and expect several times
+//           more cycles per unit on a core without caches)
+// tools/budget.c measures both on the host.
+#if defined(MAZE_EMBEDDED) && !defined(MAZE_RAM_BUDGET)
+#define MAZE_RAM_BUDGET 8192 // bytes of static RAM the solver may use
+#endif
+
+// Anytime planning: units of flood work one floodFill() call may do before
+// it returns and picks up where it stopped on the next call (0 = no limit).
+// A unit is one cell expanded or FLOOD_CLEAR_CELLS cells of a fresh field
+// reset. Bounds the work per solver() call to about FLOOD_BUDGET times the
+// per-unit cost tools/budget.c reports. Can be changed at run time through
+// solverStatus.floodBudget.
+#ifndef FLOOD_BUDGET
+#define FLOOD_BUDGET 0
+#endif
+#ifndef FLOOD_CLEAR_CELLS
+#define FLOOD_CLEAR_CELLS 16 // one store each, against 4 neighbor checks for an expansion
+#endif
+
+// Distance fields floodFill() keeps, keyed by the Zobrist hash of the walls
+// (0 turns the cache off). solver() only refloods when a wall is new, so
+// within one exploration every wall set is flooded once; the cache pays off
+// after a reset (API_wasReset()), when the mouse starts over and learns the
+// same walls in the same order. That replays the wall sets oldest first, so
+// an LRU cache hits only if it holds every flood of the run: 16x16 runs
+// take 20 to 90 floods (tools/budget.c prints the count and the hit rate
+// after a reset). The embedded profile has no room for that many and keeps
+// none; large grids keep a few for tools that reflood the same walls.
+#ifndef FLOOD_CACHE_SIZE
+#ifdef MAZE_EMBEDDED
+#define FLOOD_CACHE_SIZE 0
+#else
+#define FLOOD_CACHE_SIZE (GRID_SIZE <= 32 ? 128 : 8)
+#endif
+#endif
+
 #define NORTH 0
 #define EAST 1
 #define SOUTH 2
@@ -50,8 +101,7 @@ typedef enum Action
 // ===== Structs (ONLY here) =====
 typedef struct
 {
-    unsigned char walls; // bitmask of walls (N/E/S/W)
-    int distance;        // flood fill distance
+    unsigned char walls; // bitmask of walls (N/E/S/W); distances live in solver.c
     int row;
     int col;
 } Cell;
@@ -66,13 +116,21 @@ typedef struct Queue
 // Global maze (declared here, defined in solver.c)
 extern Cell maze[GRID_SIZE][GRID_SIZE];
 
+// Movement tables indexed by NORTH/EAST/SOUTH/WEST, shared by every file
+// that walks a grid. static const: each user gets a read-only copy (flash on
+// the MCU), so including solver.h never drags in solver.c.
+static const int dRow[4] = {-1, 0, 1, 0};
+static const int dCol[4] = {0, 1, 0, -1};
+static const unsigned char dirMask[4] = {WALL_N, WALL_E, WALL_S, WALL_W};
+
 // ===== Function prototypes =====
 Action solver();
 Action leftWallFollower();
-void floodFill();
+int floodFill(); // returns 1 once the distances match the current walls
 
 void initSet();
 void addWall(int r, int c, int dir);
+int cellDistance(int r, int c); // flood fill distance, -1 = blank
 int isBlank(Cell *cell);
 void resetDistances();
 void setOuterWalls();
@@ -80,13 +138,40 @@ void setOuterWalls();
 int turnLeftDir(int dir);
 int turnRightDir(int dir);
 
-Action planMove(int row, int col, int targetRow, int targetCol, int *dir);
-
 // Queue functions
-Queue *createQueue();
+void initQueue(Queue *queue);
 Cell *getRear(Queue *queue);
 Cell *getFront(Queue *queue);
 void enqueue(Queue *queue, Cell *cell);
 Cell *dequeue(Queue *queue);
 // Debugging functions
+
+void floodCacheReset(); // forget every cached field and zero the counters
+
+// What tools may read and set of the solver's planning, kept in one struct
+// so that the static RAM count covers it with sizeof().
+typedef struct
+{
+    // Zobrist hash of every known wall, kept up to date by addWall() and
+    // reset by initSet(), and the floodFill() cache counters
+    unsigned long long wallHash;
+    unsigned long floodCacheHits;
+    unsigned long floodCacheMisses;
+
+    // Anytime planning: the current budget, the units the last floodFill()
+    // call spent, whether the last solver() decision was made on incomplete
+    // data (a flood still running that has not reached the mouse, or a field
+    // flooded from older walls) and how many such decisions there have been.
+    int floodBudget;
+    int floodWorkDone;
+    int decisionIncomplete;
+    unsigned long incompleteDecisions;
+} SolverStatus;
+
+extern SolverStatus solverStatus;
+
+// Static RAM used by solver.c (maze, flood queue, distance fields, flood
+// cache and state) and the flood cache's share of it
+extern const unsigned long solverRamBytes;
+extern const unsigned long floodCacheBytes;
 #endif
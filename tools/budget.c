@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../API.h"
+#include "../mazegen.h"
+#include "../solver.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Host-side budget report for the embedded profile. Links solver.c exactly as
+// the MCU build does and stands in for the board with a Linux stub of the HAL
+// in API.h, driven by a generated or loaded maze.
+// Build: gcc -O2 -DMAZE_EMBEDDED -DMAZE_NO_DISPLAY tools/budget.c solver.c mazegen.c -o budget
+//
+//   budget [-n MAX_STEPS] [-b UNITS] [MAZE]
+//       MAZE is a GRID_SIZE x GRID_SIZE .num file or ALGORITHM:SIZE:SEED
+//       (default competition:GRID_SIZE:1).
+//       Prints the static RAM breakdown against MAZE_RAM_BUDGET, the cost of
+//       a worst-case floodFill() and the slowest solver() call while the
+//       mouse explores MAZE with a flood budget of UNITS per call
+//       (default FLOOD_BUDGET, 0 = no limit), twice: the second run starts
+//       after a reset and shows what the flood cache saves.
+//
+// Exits with 1 when a bound documented in solver.h does not hold: the RAM
+// total over MAZE_RAM_BUDGET, a floodFill() call doing more units than the
+// budget, a whole flood doing more than GRID_SIZE^2 / FLOOD_CLEAR_CELLS +
+// GRID_SIZE^2 units, or the mouse not reaching the goal in MAX_STEPS.
+//
+// Cycle counts come from the host TSC (nanoseconds where there is none), so
+// they size the work, not the MCU time: scale by the ratio of clock speeds
+// and expect more on a core without caches or branch prediction. The bounds
+// are checked in units, which do not depend on the host.
+//
+// Built with -DUSE_HPA instead (a host build: HPA is not part of the
+// embedded profile), budget times the hierarchical planner: the solver()
+// calls of one exploration of MAZE against a full reflood of the same grid.
+// GRID_SIZE is fixed at build time, so a size sweep is one build per size:
+//   for n in 32 64 128 256 512; do
+//       gcc -O2 -DUSE_HPA -DMAZE_NO_DISPLAY -DGRID_SIZE=$n tools/budget.c solver.c hpa.c mazegen.c -o budget-hpa &&
+//       ./budget-hpa -n 1000000 kruskal:$n:1; done
+
+#if !defined(MAZE_EMBEDDED) && !defined(USE_HPA)
+#error "build the budget tool with -DMAZE_EMBEDDED so it measures the embedded profile"
+#endif
+
+#define FLOOD_REPEATS 2000
+// most units one whole flood may take: clear the work field, expand every cell
+#define FLOOD_UNIT_BOUND ((GRID_SIZE * GRID_SIZE + FLOOD_CLEAR_CELLS - 1) / FLOOD_CLEAR_CELLS + GRID_SIZE * GRID_SIZE)
+
+// ===== Linux stub of the HAL =====
+
+static Maze *board;
+static int mouseRow;
+static int mouseCol;
+static int mouseHeading = NORTH;
+
+int API_mazeWidth() { return board->width; }
+int API_mazeHeight() { return board->height; }
+
+int API_wallFront() { return mazeHasWall(board, mouseRow, mouseCol, mouseHeading); }
+int API_wallRight() { return mazeHasWall(board, mouseRow, mouseCol, (mouseHeading + 1) % 4); }
+int API_wallLeft() { return mazeHasWall(board, mouseRow, mouseCol, (mouseHeading + 3) % 4); }
+
+int API_moveForward()
+{
+    if (API_wallFront())
+        return 0;
+    mouseRow += dRow[mouseHeading];
+    mouseCol += dCol[mouseHeading];
+    return 1;
+}
+
+void API_turnRight() { mouseHeading = (mouseHeading + 1) % 4; }
+void API_turnLeft() { mouseHeading = (mouseHeading + 3) % 4; }
+
+static int resetPending;
+int API_wasReset() { return resetPending; }
+void API_ackReset() { resetPending = 0; }
+
+#ifndef MAZE_EMBEDDED
+void debug_log(char *text) { (void)text; }
+#endif
+
+#ifndef MAZE_NO_DISPLAY
+void API_setWall(int x, int y, char direction) { (void)x; (void)y; (void)direction; }
+void API_clearWall(int x, int y, char direction) { (void)x; (void)y; (void)direction; }
+void API_setColor(int x, int y, char color) { (void)x; (void)y; (void)color; }
+void API_clearColor(int x, int y) { (void)x; (void)y; }
+void API_clearAllColor() {}
+void API_setText(int x, int y, char *str) { (void)x; (void)y; (void)str; }
+void API_clearText(int x, int y) { (void)x; (void)y; }
+void API_clearAllText() {}
+#endif
+
+// ===== Measurements =====
+
+static unsigned long long cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static int isGoal(int r, int c)
+{
+    int goal = GRID_SIZE / 2;
+    return (r == goal || r == goal - 1) && (c == goal || c == goal - 1);
+}
+
+static int compareCycles(const void *a, const void *b)
+{
+    unsigned long long x = *(const unsigned long long *)a;
+    unsigned long long y = *(const unsigned long long *)b;
+    return (x > y) - (x < y);
+}
+
+#ifndef USE_HPA
+// Returns 0 when the total is over MAZE_RAM_BUDGET.
+static int reportRam()
+{
+    unsigned long state = solverRamBytes - (unsigned long)sizeof(maze) - (unsigned long)sizeof(solverStatus);
+    printf("static RAM (GRID_SIZE %d, %d-bit pointers)\n", GRID_SIZE, (int)sizeof(void *) * 8);
+    printf("  maze          %6lu bytes (%d cells x %lu)\n",
+           (unsigned long)sizeof(maze), GRID_SIZE * GRID_SIZE, (unsigned long)sizeof(Cell));
+    printf("  flood queue   %6lu bytes\n", (unsigned long)sizeof(Queue));
+    printf("  flood cache   %6lu bytes (%d fields)\n", floodCacheBytes, FLOOD_CACHE_SIZE);
+    printf("  other state   %6lu bytes (fields in use, flood and turn state, status)\n",
+           state - (unsigned long)sizeof(Queue) - floodCacheBytes + (unsigned long)sizeof(solverStatus));
+    printf("  total         %6lu of %d bytes (MAZE_RAM_BUDGET)\n", solverRamBytes, MAZE_RAM_BUDGET);
+    if (solverRamBytes > MAZE_RAM_BUDGET)
+    {
+        printf("  OVER BUDGET by %lu bytes\n", solverRamBytes - MAZE_RAM_BUDGET);
+        return 0;
+    }
+    return 1;
+}
+
+// The flood visits every reachable cell once, so the worst case is a maze
+// where every cell is reachable: the open grid initSet() starts from. The
+// work is the same every run; the spread is the host (caches, preemption).
+static unsigned long long timeFloods(int cached, unsigned long long *median)
+{
+    static unsigned long long samples[FLOOD_REPEATS];
+    for (int i = 0; i < FLOOD_REPEATS; i++)
+    {
+        initSet();
+        if (!cached)
+            floodCacheReset();
+        unsigned long long start = cycles();
+        floodFill();
+        samples[i] = cycles() - start;
+    }
+    qsort(samples, FLOOD_REPEATS, sizeof(samples[0]), compareCycles);
+    *median = samples[FLOOD_REPEATS / 2];
+    return samples[0];
+}
+
+// Returns 0 when the flood takes more units than FLOOD_UNIT_BOUND.
+static int reportWorstFlood()
+{
+    solverStatus.floodBudget = 0; // whole floods only
+    unsigned long long median;
+    unsigned long long best = timeFloods(0, &median);
+    int units = solverStatus.floodWorkDone;
+
+    int reached = 0;
+    for (int r = 0; r < GRID_SIZE; r++)
+        for (int c = 0; c < GRID_SIZE; c++)
+            reached += !isBlank(&maze[r][c]);
+
+    printf("worst-case floodFill (open grid, %d cells reached, %d neighbor checks)\n", reached, reached * 4);
+    printf("  %d units of at most %d\n", units, FLOOD_UNIT_BOUND);
+    printf("  %llu cycles best, %llu median of %d runs, %.1f per unit\n",
+           best, median, FLOOD_REPEATS, (double)best / units);
+#if FLOOD_CACHE_SIZE > 0
+    best = timeFloods(1, &median);
+    printf("  %llu cycles best, %llu median when the field is cached\n", best, median);
+#endif
+    if (units > FLOOD_UNIT_BOUND)
+    {
+        printf("  OVER BOUND\n");
+        return 0;
+    }
+    return 1;
+}
+
+// The worst single call on a shared host is usually a preemption, so the
+// 99.9th percentile is printed next to it. Returns 0 when the goal is not
+// reached or a call did more flood work than the budget.
+static int reportExploration(const char *spec, const char *run, long maxSteps)
+{
+    unsigned long hitsBefore = solverStatus.floodCacheHits;
+    unsigned long missesBefore = solverStatus.floodCacheMisses;
+    unsigned long incompleteBefore = solverStatus.incompleteDecisions;
+    unsigned long long *samples = malloc(sizeof(unsigned long long) * maxSteps);
+    unsigned long long total = 0;
+    long steps = 0;
+    int mostUnits = 0;
+    while (steps < maxSteps && !isGoal(mouseRow, mouseCol))
+    {
+        solverStatus.floodWorkDone = 0; // solver() does not flood on every call
+        unsigned long long start = cycles();
+        Action action = solver();
+        unsigned long long spent = cycles() - start;
+        total += spent;
+        samples[steps++] = spent;
+        if (solverStatus.floodWorkDone > mostUnits)
+            mostUnits = solverStatus.floodWorkDone;
+
+        if (action == FORWARD)
+            API_moveForward();
+        else if (action == LEFT)
+            API_turnLeft();
+        else if (action == RIGHT)
+            API_turnRight();
+    }
+
+    int reached = isGoal(mouseRow, mouseCol);
+    int budget = solverStatus.floodBudget;
+    printf("exploring %s, %s: %s after %ld solver() calls, flood budget %d\n", spec, run,
+           reached ? "goal reached" : "goal NOT reached", steps, budget);
+    qsort(samples, steps, sizeof(samples[0]), compareCycles);
+    if (steps)
+        printf("  %llu cycles worst call, %llu at 99.9%%, %.0f average\n",
+               samples[steps - 1], samples[steps - 1 - steps / 1000], (double)total / steps);
+    free(samples);
+    printf("  %d flood units in the busiest call%s\n", mostUnits,
+           budget > 0 && mostUnits > budget ? ", OVER BUDGET" : "");
+    unsigned long hits = solverStatus.floodCacheHits - hitsBefore;
+    unsigned long floods = hits + solverStatus.floodCacheMisses - missesBefore;
+    printf("  %lu floods, %lu from the cache (%.0f%%)\n", floods, hits, floods ? 100.0 * hits / floods : 0.0);
+    printf("  %lu decisions on an incomplete flood\n", solverStatus.incompleteDecisions - incompleteBefore);
+    return reached && (budget == 0 || mostUnits <= budget);
+}
+#else
+// The planner's cost per step as the grid grows, against what the plain
+// flood fill pays whenever a wall is new. Returns 0 when the goal is not
+// reached.
+static int reportHpa(const char *spec, long maxSteps)
+{
+    unsigned long long *samples = malloc(sizeof(unsigned long long) * maxSteps);
+    unsigned long long total = 0;
+    long steps = 0;
+    while (steps < maxSteps && !isGoal(mouseRow, mouseCol))
+    {
+        unsigned long long start = cycles();
+        Action action = solver();
+        unsigned long long spent = cycles() - start;
+        total += spent;
+        samples[steps++] = spent;
+
+        if (action == FORWARD)
+            API_moveForward();
+        else if (action == LEFT)
+            API_turnLeft();
+        else if (action == RIGHT)
+            API_turnRight();
+    }
+
+    // what the plain planner would pay on every new wall: a whole flood of
+    // the walls the mouse knows by now
+    unsigned long long reflood = ~0ull;
+    for (int i = 0; i < 5; i++)
+    {
+        resetDistances();
+        floodCacheReset();
+        unsigned long long start = cycles();
+        floodFill();
+        unsigned long long spent = cycles() - start;
+        if (spent < reflood)
+            reflood = spent;
+    }
+
+    int reached = isGoal(mouseRow, mouseCol);
+    printf("hpa %dx%d %s: %s after %ld solver() calls\n", GRID_SIZE, GRID_SIZE, spec,
+           reached ? "goal reached" : "goal NOT reached", steps);
+    if (steps)
+    {
+        unsigned long long first = samples[0];
+        qsort(samples, steps, sizeof(samples[0]), compareCycles);
+        printf("  %llu cycles first call (builds every cluster), %.0f average, %llu median, %llu at 99.9%%\n",
+               first, (double)total / steps, samples[steps / 2], samples[steps - 1 - steps / 1000]);
+    }
+    printf("  %llu cycles for a full reflood of the same walls\n", reflood);
+    free(samples);
+    return reached;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    long maxSteps = 100000;
+    char defaultSpec[32];
+    snprintf(defaultSpec, sizeof(defaultSpec), "competition:%d:1", GRID_SIZE);
+    const char *spec = defaultSpec;
+    int i = 1;
+
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+    {
+        if (argv[i][1] == 'n')
+            maxSteps = atol(argv[i + 1]);
+        else if (argv[i][1] == 'b')
+            solverStatus.floodBudget = atoi(argv[i + 1]);
+        else
+            break;
+    }
+    if (i < argc)
+        spec = argv[i];
+
+    board = openMazeSpec(spec);
+    if (!board || board->width != GRID_SIZE || board->height != GRID_SIZE)
+    {
+        fprintf(stderr, "cannot load a %dx%d maze from %s\n", GRID_SIZE, GRID_SIZE, spec);
+        return 1;
+    }
+    mouseRow = GRID_SIZE - 1;
+    mouseCol = 0;
+
+#ifdef USE_HPA
+    int ok = reportHpa(spec, maxSteps);
+#else
+    int ok = reportRam();
+    // solver() keeps its position in statics, so explore before the flood
+    // benchmark takes over the maze array. The second run starts over after
+    // a reset, the way the simulator's reset button does: the solver forgets
+    // the walls but keeps its flood cache.
+    ok = reportExploration(spec, "first run", maxSteps) && ok;
+    mouseRow = GRID_SIZE - 1;
+    mouseCol = 0;
+    mouseHeading = NORTH;
+    resetPending = 1;
+    ok = reportExploration(spec, "after a reset", maxSteps) && ok;
+    ok = reportWorstFlood() && ok;
+#endif
+
+    freeMaze(board);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../mazegen.h"
+
+// Command line front end for the maze generator.
+// Build: gcc -O2 tools/mazegen.c mazegen.c -o mazegen
+//
+//   mazegen ALGORITHM WIDTH HEIGHT SEED [LOOP_RATIO] OUTPUT.num|OUTPUT.map
+//   mazegen -corpus ALGORITHM SIZE FIRST_SEED COUNT [LOOP_RATIO] DIRECTORY
+//   mazegen -bench ALGORITHM SIZE COUNT [LOOP_RATIO]
+//
+// -corpus writes DIRECTORY/<algorithm>_<size>_<seed>.num for COUNT seeds.
+// -bench generates COUNT mazes in memory and reports the rate.
+
+static void usage()
+{
+    fprintf(stderr,
+            "usage: mazegen ALGORITHM WIDTH HEIGHT SEED [LOOP_RATIO] OUTPUT\n"
+            "       mazegen -corpus ALGORITHM SIZE FIRST_SEED COUNT [LOOP_RATIO] DIRECTORY\n"
+            "       mazegen -bench ALGORITHM SIZE COUNT [LOOP_RATIO]\n"
+            "algorithms: backtracker kruskal wilson braided competition\n");
+}
+
+static int algorithmArg(const char *name)
+{
+    int algorithm = parseMazeAlgorithm(name);
+    if (algorithm < 0)
+        fprintf(stderr, "unknown algorithm: %s\n", name);
+    return algorithm;
+}
+
+static int bench(int argc, char *argv[])
+{
+    if (argc < 5)
+    {
+        usage();
+        return 1;
+    }
+    int algorithm = algorithmArg(argv[2]);
+    int size = atoi(argv[3]);
+    long count = atol(argv[4]);
+    double loopRatio = argc > 5 ? atof(argv[5]) : 0.5;
+    if (algorithm < 0 || size <= 0 || count <= 0)
+        return 1;
+
+    Maze *maze = createMaze(size, size);
+    if (!maze)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    unsigned long checksum = 0;
+    for (long i = 0; i < count; i++)
+    {
+        generateMaze(maze, algorithm, (unsigned long long)i, loopRatio);
+        checksum += maze->walls[i % (size * size)];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("%s %dx%d: %ld mazes in %.3f s (%.0f mazes/s, %.1f ns/cell) checksum %lu\n",
+           mazeAlgorithmName(algorithm), size, size, count, seconds, count / seconds,
+           seconds * 1e9 / ((double)count * size * size), checksum);
+    freeMaze(maze);
+    return 0;
+}
+
+static int corpus(int argc, char *argv[])
+{
+    if (argc < 7)
+    {
+        usage();
+        return 1;
+    }
+    int algorithm = algorithmArg(argv[2]);
+    int size = atoi(argv[3]);
+    unsigned long long firstSeed = strtoull(argv[4], NULL, 10);
+    long count = atol(argv[5]);
+    double loopRatio = argc > 7 ? atof(argv[6]) : 0.5;
+    const char *directory = argv[argc - 1];
+    if (algorithm < 0 || size <= 0 || count <= 0)
+        return 1;
+
+    Maze *maze = createMaze(size, size);
+    if (!maze)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    char path[4096];
+    for (long i = 0; i < count; i++)
+    {
+        unsigned long long seed = firstSeed + i;
+        generateMaze(maze, algorithm, seed, loopRatio);
+        snprintf(path, sizeof(path), "%s/%s_%d_%llu.num", directory, mazeAlgorithmName(algorithm), size, seed);
+        if (saveMaze(maze, path) != 0)
+        {
+            fprintf(stderr, "cannot write %s\n", path);
+            freeMaze(maze);
+            return 1;
+        }
+    }
+    freeMaze(maze);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "-bench") == 0)
+        return bench(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "-corpus") == 0)
+        return corpus(argc, argv);
+
+    if (argc < 6)
+    {
+        usage();
+        return 1;
+    }
+    int algorithm = algorithmArg(argv[1]);
+    int width = atoi(argv[2]);
+    int height = atoi(argv[3]);
+    unsigned long long seed = strtoull(argv[4], NULL, 10);
+    double loopRatio = argc > 6 ? atof(argv[5]) : 0.5;
+    const char *output = argv[argc - 1];
+    if (algorithm < 0 || width <= 0 || height <= 0)
+        return 1;
+
+    Maze *maze = createMaze(width, height);
+    if (!maze)
+    {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    generateMaze(maze, algorithm, seed, loopRatio);
+    int result = saveMaze(maze, output);
+    if (result != 0)
+        fprintf(stderr, "cannot write %s\n", output);
+    freeMaze(maze);
+    return result ? 1 : 0;
+}
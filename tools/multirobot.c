@@ -0,0 +1,174 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../mazegen.h"
+#include "../robot.h"
+
+// Multi-robot exploration harness: N robots, one thread each, share one
+// SharedMap while exploring the same maze. Every tick each robot senses,
+// publishes its walls and takes one action; a barrier between ticks models
+// the robots moving at the same speed. The run ends when every robot is on
+// the goal (or after MAX_TICKS). A move into a wall of the real maze is
+// counted as a crash and the robot stays where it was.
+// Build: gcc -O2 -pthread tools/multirobot.c robot.c sharedmap.c flood.c mazegen.c -o multirobot
+//
+//   multirobot [-r MAX_ROBOTS] [-n MAX_TICKS] [-same-start] MAZE
+//       MAZE is a GRID_SIZE x GRID_SIZE .num file or ALGORITHM:SIZE:SEED.
+//       Runs 1..MAX_ROBOTS robots and prints the exploration time for each.
+//       Robots start in different corners unless -same-start is given.
+
+typedef struct
+{
+    Robot *robot;
+    Maze *maze;
+    SharedMap *map;
+    pthread_barrier_t *barrier;
+    _Atomic int *done;
+    long maxTicks;
+    _Atomic long *firstArrival;
+    long crashes;
+} Worker;
+
+static void *runRobot(void *arg)
+{
+    Worker *w = (Worker *)arg;
+    Robot *robot = w->robot;
+
+    for (long tick = 0; tick < w->maxTicks; tick++)
+    {
+        int h = robot->pose.heading;
+        robotSense(robot, w->map,
+                   mazeHasWall(w->maze, robot->pose.row, robot->pose.col, h),
+                   mazeHasWall(w->maze, robot->pose.row, robot->pose.col, (h + 1) % 4),
+                   mazeHasWall(w->maze, robot->pose.row, robot->pose.col, (h + 3) % 4));
+        int row = robot->pose.row;
+        int col = robot->pose.col;
+        if (robotStep(robot, w->map) == FORWARD && mazeHasWall(w->maze, row, col, robot->pose.heading))
+        {
+            // the robot would have driven through a wall: reject the move
+            w->crashes++;
+            robot->pose.row = row;
+            robot->pose.col = col;
+        }
+
+        if (robotAtGoal(robot))
+        {
+            long expected = -1;
+            atomic_compare_exchange_strong(w->firstArrival, &expected, tick + 1);
+        }
+
+        // everyone finishes the tick, the main thread decides whether to
+        // stop, then everyone reads that decision
+        pthread_barrier_wait(w->barrier);
+        pthread_barrier_wait(w->barrier);
+        if (atomic_load(w->done))
+            break;
+    }
+    return NULL;
+}
+
+static void runTeam(Maze *maze, int count, long maxTicks, int sameStart)
+{
+    static const int startRow[4] = {GRID_SIZE - 1, 0, 0, GRID_SIZE - 1};
+    static const int startCol[4] = {0, 0, GRID_SIZE - 1, GRID_SIZE - 1};
+    static const int startHeading[4] = {NORTH, SOUTH, SOUTH, NORTH};
+
+    SharedMap *map = malloc(sizeof(SharedMap));
+    Robot *robots = malloc(sizeof(Robot) * count);
+    Worker *workers = malloc(sizeof(Worker) * count);
+    pthread_t *threads = malloc(sizeof(pthread_t) * count);
+    pthread_barrier_t barrier;
+    _Atomic int done = 0;
+    _Atomic long firstArrival = -1;
+    long ticks = 0;
+
+    sharedMapInit(map);
+    pthread_barrier_init(&barrier, NULL, count + 1);
+
+    for (int i = 0; i < count; i++)
+    {
+        int corner = sameStart ? 0 : i % 4;
+        robotInit(&robots[i], i, startRow[corner], startCol[corner], startHeading[corner]);
+        workers[i] = (Worker){&robots[i], maze, map, &barrier, &done, maxTicks, &firstArrival, 0};
+    }
+
+    double start = benchSeconds();
+    for (int i = 0; i < count; i++)
+        pthread_create(&threads[i], NULL, runRobot, &workers[i]);
+
+    // the main thread joins every barrier and decides when the team is done
+    for (long tick = 0; tick < maxTicks; tick++)
+    {
+        pthread_barrier_wait(&barrier);
+        int all = 1;
+        for (int i = 0; i < count; i++)
+            all = all && robotAtGoal(&robots[i]);
+        ticks = tick + 1;
+        if (all || tick + 1 == maxTicks)
+            atomic_store(&done, 1);
+        pthread_barrier_wait(&barrier);
+        if (atomic_load(&done))
+            break;
+    }
+
+    for (int i = 0; i < count; i++)
+        pthread_join(threads[i], NULL);
+    double elapsed = benchSeconds() - start;
+
+    long floods = 0;
+    long crashes = 0;
+    for (int i = 0; i < count; i++)
+    {
+        floods += robots[i].floods;
+        crashes += workers[i].crashes;
+    }
+    printf("%2d robot%s: first on goal after %5ld ticks, all after %5ld ticks, %6ld floods (%u walls found), %ld crashes, %.3f ms\n",
+           count, count == 1 ? " " : "s", atomic_load(&firstArrival), ticks,
+           floods, sharedMapGeneration(map), crashes, elapsed * 1e3);
+
+    pthread_barrier_destroy(&barrier);
+    free(threads);
+    free(workers);
+    free(robots);
+    free(map);
+}
+
+int main(int argc, char *argv[])
+{
+    int maxRobots = 8;
+    long maxTicks = 100000;
+    int sameStart = 0;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            maxRobots = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            maxTicks = atol(argv[++i]);
+        else if (strcmp(argv[i], "-same-start") == 0)
+            sameStart = 1;
+        else
+            break;
+    }
+
+    if (i >= argc)
+    {
+        fprintf(stderr, "usage: multirobot [-r MAX_ROBOTS] [-n MAX_TICKS] [-same-start] MAZE\n");
+        return 1;
+    }
+
+    Maze *maze = openMazeSpec(argv[i]);
+    if (!maze || maze->width != GRID_SIZE || maze->height != GRID_SIZE)
+    {
+        fprintf(stderr, "cannot load a %dx%d maze from %s\n", GRID_SIZE, GRID_SIZE, argv[i]);
+        return 1;
+    }
+
+    for (int count = 1; count <= maxRobots; count++)
+        runTeam(maze, count, maxTicks, sameStart);
+
+    freeMaze(maze);
+    return 0;
+}
@@ -0,0 +1,1153 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../flood.h"
+#include "../mazegen.h"
+#include "../solver.h"
+
+// Route-query daemon: loads mazes once and answers batched path queries on a
+// Unix domain socket, so tools do not each carry their own pathfinding.
+// Build: gcc -O2 -pthread tools/routed.c flood.c mazegen.c -o routed
+//
+//   routed [-s SOCKET] [-t THREADS] [-c FIELDS] [-i SECONDS] MAZE...
+//       Serves each MAZE (a .num file or ALGORITHM:SIZE:SEED) under its
+//       index, keeping up to FIELDS distance fields per maze (default 16).
+//       One thread multiplexes every connection with poll() and hands each
+//       complete batch to one of THREADS workers (default 4), so a worker is
+//       busy only while it answers a batch, never while a client is idle.
+//       Connections idle for SECONDS (default 60) are closed. SOCKET
+//       defaults to /tmp/routed.sock; routed refuses to start while another
+//       daemon answers on it.
+//   routed -client [SOCKET]
+//       Sends stdin to the daemon and prints the replies.
+//   routed -bench [SOCKET] [CLIENTS] [BATCHES]
+//       Times CLIENTS concurrent clients sending BATCHES batches of random
+//       queries each, then prints the daemon's cache counters.
+//
+// Protocol: one query per line, answered by one line starting with OK or
+// ERR. A blank line ends a batch: replies are buffered until then, so a
+// batch costs one round trip. Cells are ROW COL with row 0 on the north
+// edge, headings and route steps are N E S W.
+//
+//   MAZES                      OK COUNT ID:WxH:NAME...
+//   FIELD M [R C]              OK W H D...     distances to the center goal,
+//                                              or to cell (R, C); -1 = unreachable
+//   DIST M R C [R2 C2]         OK D            steps from (R, C) to the goal or (R2, C2)
+//   ROUTE M R C [R2 C2]        OK LEN STEPS    a shortest route, fewest turns
+//                                              among equals ("-" when LEN is 0)
+//   FAST M R C H [CELL TURN]   OK COST CMD...  cheapest run to the goal facing H,
+//                                              at CELL per cell + TURN per 90
+//                                              degrees: Fn (n cells forward),
+//                                              L, R, U (180)
+//   STATS                      OK M:HITS:MISSES:FIELDS...
+//
+// ROUTE and FAST search over (cell, heading), so turns count while the route
+// is chosen; the cached field to the target is the search's lower bound.
+
+#define DEFAULT_SOCKET "/tmp/routed.sock"
+#define DEFAULT_THREADS 4
+#define DEFAULT_FIELDS 16
+#define DEFAULT_CELL_COST 10
+#define DEFAULT_TURN_COST 7
+#define PENDING_CLIENTS 64
+#define DEFAULT_IDLE_SECONDS 60
+#define MAX_BATCH_BYTES (1 << 20) // unanswered input one connection may buffer
+#define GOAL_TARGET -1
+#define BENCH_BATCH 32
+#define BENCH_TARGETS 12
+
+static const char stepName[4] = {'N', 'E', 'S', 'W'};
+
+// One cached distance field. A field in use (refs > 0) is never evicted.
+typedef struct
+{
+    int target; // cell index, or GOAL_TARGET for the center goal
+    int refs;
+    unsigned long lastUsed;
+    int *dist; // NULL = empty slot
+} Field;
+
+typedef struct
+{
+    const char *name;
+    Maze *maze;
+    int goals[4];
+    int goalCount;
+
+    pthread_mutex_t lock; // guards everything below
+    Field *fields;        // LRU cache of fieldCapacity fields
+    unsigned long clock;
+    unsigned long hits;
+    unsigned long misses;
+} Served;
+
+// Per-worker work space for floods and route searches, sized for the
+// largest maze. A search state is cell * 4 + heading.
+typedef struct
+{
+    int *queue;          // flood queue, one int per cell
+    long long *cost;     // cheapest cost found per state
+    int *parent;         // state the cheapest route came from, -1 at the start
+    unsigned int *stamp; // cost and parent are set when stamp == generation
+    unsigned int generation;
+    long long *heapKey;  // open states, a binary min-heap on cost + estimate
+    int *heapState;
+    char *steps;         // the route found, one direction per step
+} Scratch;
+
+static Served *served;
+static int servedCount;
+static int fieldCapacity = DEFAULT_FIELDS;
+static int maxCells;
+
+// One client connection. Only the poll thread touches a connection, except
+// for batch and reply while a worker holds it (busy).
+typedef struct Connection
+{
+    int fd;
+    char *input; // received bytes not yet handed to a worker
+    size_t inputLength;
+    size_t inputSize;
+    size_t inputScanned; // start of the first line of input not yet complete
+    char *batch;      // the batch a worker is answering
+    int batchClosed;  // batch ended with a blank line (otherwise the client hung up mid-batch)
+    char *reply;      // replies to send
+    size_t replyLength;
+    size_t replySent;
+    int busy;         // a worker holds the batch
+    int eof;          // the client will send nothing more
+    double lastActive;
+    struct Connection *next; // in the batch queue or the done list
+} Connection;
+
+static int idleSeconds = DEFAULT_IDLE_SECONDS;
+
+// Batches waiting for a worker, and answered ones waiting for the poll
+// thread, which a byte on wakeFds[1] tells to look
+static Connection *queueHead = NULL;
+static Connection *queueTail = NULL;
+static Connection *doneList = NULL;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueReady = PTHREAD_COND_INITIALIZER;
+static int wakeFds[2];
+
+// ===== Distance field cache =====
+
+// Hand out the field for target, flooding it on a miss. The flood runs
+// outside the lock so other queries on the same maze are not held up; if
+// two threads miss on the same target at once the second copy is dropped.
+static Field *acquireField(Served *s, int target, int *queue)
+{
+    pthread_mutex_lock(&s->lock);
+    for (int i = 0; i < fieldCapacity; i++)
+    {
+        Field *f = &s->fields[i];
+        if (f->dist && f->target == target)
+        {
+            f->refs++;
+            f->lastUsed = ++s->clock;
+            s->hits++;
+            pthread_mutex_unlock(&s->lock);
+            return f;
+        }
+    }
+    s->misses++;
+    pthread_mutex_unlock(&s->lock);
+
+    int cells = s->maze->width * s->maze->height;
+    int *dist = malloc(sizeof(int) * cells);
+    if (target == GOAL_TARGET)
+        floodWalls(s->maze->walls, s->maze->width, s->maze->height, s->goals, s->goalCount, dist, queue);
+    else
+        floodWalls(s->maze->walls, s->maze->width, s->maze->height, &target, 1, dist, queue);
+
+    pthread_mutex_lock(&s->lock);
+    Field *victim = NULL;
+    for (int i = 0; i < fieldCapacity; i++)
+    {
+        Field *f = &s->fields[i];
+        if (f->dist && f->target == target)
+        {
+            // someone else flooded it meanwhile
+            free(dist);
+            f->refs++;
+            f->lastUsed = ++s->clock;
+            pthread_mutex_unlock(&s->lock);
+            return f;
+        }
+        if (f->refs == 0 && (!victim || !f->dist || (victim->dist && f->lastUsed < victim->lastUsed)))
+            victim = f;
+    }
+
+    if (!victim)
+    {
+        // every slot is in use: hand out a field that is not cached
+        pthread_mutex_unlock(&s->lock);
+        Field *f = malloc(sizeof(Field));
+        *f = (Field){target, 1, 0, dist};
+        return f;
+    }
+
+    free(victim->dist);
+    *victim = (Field){target, 1, ++s->clock, dist};
+    pthread_mutex_unlock(&s->lock);
+    return victim;
+}
+
+static void releaseField(Served *s, Field *f)
+{
+    if (f >= s->fields && f < s->fields + fieldCapacity)
+    {
+        pthread_mutex_lock(&s->lock);
+        f->refs--;
+        pthread_mutex_unlock(&s->lock);
+        return;
+    }
+    free(f->dist);
+    free(f);
+}
+
+// ===== Queries =====
+
+static int canMove(const Maze *maze, int r, int c, int dir)
+{
+    return wallsOpen(maze->walls, maze->width, maze->height, r * maze->width + c, dir);
+}
+
+static void heapPush(Scratch *w, int *size, long long key, int state)
+{
+    int i = (*size)++;
+    while (i > 0 && w->heapKey[(i - 1) / 2] > key)
+    {
+        w->heapKey[i] = w->heapKey[(i - 1) / 2];
+        w->heapState[i] = w->heapState[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    w->heapKey[i] = key;
+    w->heapState[i] = state;
+}
+
+static int heapPop(Scratch *w, int *size, long long *key)
+{
+    int top = w->heapState[0];
+    *key = w->heapKey[0];
+    long long lastKey = w->heapKey[--(*size)];
+    int lastState = w->heapState[*size];
+    int i = 0;
+    for (;;)
+    {
+        int child = 2 * i + 1;
+        if (child >= *size)
+            break;
+        if (child + 1 < *size && w->heapKey[child + 1] < w->heapKey[child])
+            child++;
+        if (w->heapKey[child] >= lastKey)
+            break;
+        w->heapKey[i] = w->heapKey[child];
+        w->heapState[i] = w->heapState[child];
+        i = child;
+    }
+    w->heapKey[i] = lastKey;
+    w->heapState[i] = lastState;
+    return top;
+}
+
+static void reachState(Scratch *w, int *heapSize, int from, int state, long long cost, long long estimate)
+{
+    if (w->stamp[state] == w->generation && w->cost[state] <= cost)
+        return;
+    w->stamp[state] = w->generation;
+    w->cost[state] = cost;
+    w->parent[state] = from;
+    heapPush(w, heapSize, cost + estimate, state);
+}
+
+// Cheapest route from (r, c) to the target of the field dist, where a cell
+// forward costs cellCost and a 90 degree turn turnCost. heading -1 lets the
+// route start facing any way. No route gets there in fewer than dist cells,
+// so dist * cellCost is an A* estimate that never overshoots. Leaves one
+// direction per step in w->steps, the cost in *total, and returns the length,
+// or -1 if the target is unreachable.
+static int searchRoute(const Maze *maze, const int *dist, int r, int c, int heading,
+                       long long cellCost, long long turnCost, Scratch *w, long long *total)
+{
+    int start = r * maze->width + c;
+    if (dist[start] < 0)
+        return -1;
+    if (++w->generation == 0)
+    {
+        // wrapped: clear the stamps so no old state looks set
+        memset(w->stamp, 0, sizeof(unsigned int) * maxCells * 4);
+        w->generation = 1;
+    }
+
+    int heapSize = 0;
+    for (int h = 0; h < 4; h++)
+    {
+        if (heading < 0 || h == heading)
+            reachState(w, &heapSize, -1, start * 4 + h, 0, dist[start] * cellCost);
+    }
+
+    int end = -1;
+    while (heapSize > 0 && end < 0)
+    {
+        long long key;
+        int state = heapPop(w, &heapSize, &key);
+        int cell = state / 4, h = state % 4;
+        long long cost = w->cost[state];
+        if (key != cost + dist[cell] * cellCost)
+            continue; // a cheaper route to this state was found after the push
+        if (dist[cell] == 0)
+        {
+            end = state;
+            break;
+        }
+
+        int next = cell + dRow[h] * maze->width + dCol[h];
+        if (canMove(maze, cell / maze->width, cell % maze->width, h) && dist[next] >= 0)
+            reachState(w, &heapSize, state, next * 4 + h, cost + cellCost, dist[next] * cellCost);
+        reachState(w, &heapSize, state, cell * 4 + (h + 1) % 4, cost + turnCost, dist[cell] * cellCost);
+        reachState(w, &heapSize, state, cell * 4 + (h + 3) % 4, cost + turnCost, dist[cell] * cellCost);
+    }
+    if (end < 0)
+        return -1;
+
+    // back from the target: every change of cell is one step
+    *total = w->cost[end];
+    int length = 0;
+    for (int state = end; w->parent[state] >= 0; state = w->parent[state])
+    {
+        if (w->parent[state] / 4 != state / 4)
+            w->steps[length++] = state % 4;
+    }
+    for (int i = 0; i < length / 2; i++)
+    {
+        char step = w->steps[i];
+        w->steps[i] = w->steps[length - 1 - i];
+        w->steps[length - 1 - i] = step;
+    }
+    return length;
+}
+
+static Served *parseMaze(const char *text, FILE *out)
+{
+    char *end;
+    long id = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || id < 0 || id >= servedCount)
+    {
+        fprintf(out, "ERR no maze %s\n", text);
+        return NULL;
+    }
+    return &served[id];
+}
+
+static int validCell(const Served *s, int r, int c, FILE *out)
+{
+    if (r < 0 || r >= s->maze->height || c < 0 || c >= s->maze->width)
+    {
+        fprintf(out, "ERR cell %d %d is outside the %dx%d maze\n", r, c, s->maze->width, s->maze->height);
+        return 0;
+    }
+    return 1;
+}
+
+static int parseHeading(const char *text)
+{
+    for (int dir = 0; dir < 4; dir++)
+    {
+        if (text[0] == stepName[dir] && text[1] == '\0')
+            return dir;
+    }
+    return -1;
+}
+
+static void answerField(Served *s, int argc, char **argv, Scratch *scratch, FILE *out)
+{
+    int target = GOAL_TARGET;
+    if (argc == 4)
+    {
+        int r = atoi(argv[2]), c = atoi(argv[3]);
+        if (!validCell(s, r, c, out))
+            return;
+        target = r * s->maze->width + c;
+    }
+    else if (argc != 2)
+    {
+        fprintf(out, "ERR usage: FIELD M [R C]\n");
+        return;
+    }
+
+    Field *f = acquireField(s, target, scratch->queue);
+    int cells = s->maze->width * s->maze->height;
+    fprintf(out, "OK %d %d", s->maze->width, s->maze->height);
+    for (int i = 0; i < cells; i++)
+        fprintf(out, " %d", f->dist[i]);
+    fputc('\n', out);
+    releaseField(s, f);
+}
+
+// DIST and ROUTE share their arguments: M R C [R2 C2]
+static void answerRoute(Served *s, int argc, char **argv, int wantSteps, Scratch *scratch, FILE *out)
+{
+    if (argc != 4 && argc != 6)
+    {
+        fprintf(out, "ERR usage: %s M R C [R2 C2]\n", argv[0]);
+        return;
+    }
+    int r = atoi(argv[2]), c = atoi(argv[3]);
+    if (!validCell(s, r, c, out))
+        return;
+    int target = GOAL_TARGET;
+    if (argc == 6)
+    {
+        int tr = atoi(argv[4]), tc = atoi(argv[5]);
+        if (!validCell(s, tr, tc, out))
+            return;
+        target = tr * s->maze->width + tc;
+    }
+
+    Field *f = acquireField(s, target, scratch->queue);
+    if (!wantSteps)
+    {
+        fprintf(out, "OK %d\n", f->dist[r * s->maze->width + c]);
+        releaseField(s, f);
+        return;
+    }
+
+    // a route turns at most twice per cell, so a cell outweighing that many
+    // turns makes the search shortest first, then fewest turns
+    long long cellCost = 2LL * s->maze->width * s->maze->height + 1;
+    long long cost;
+    int length = searchRoute(s->maze, f->dist, r, c, -1, cellCost, 1, scratch, &cost);
+    releaseField(s, f);
+    if (length < 0)
+        fprintf(out, "ERR unreachable\n");
+    else if (length == 0)
+        fprintf(out, "OK 0 -\n");
+    else
+    {
+        fprintf(out, "OK %d ", length);
+        for (int i = 0; i < length; i++)
+            fputc(stepName[(int)scratch->steps[i]], out);
+        fputc('\n', out);
+    }
+}
+
+static void answerFast(Served *s, int argc, char **argv, Scratch *scratch, FILE *out)
+{
+    if (argc != 5 && argc != 7)
+    {
+        fprintf(out, "ERR usage: FAST M R C H [CELL TURN]\n");
+        return;
+    }
+    int r = atoi(argv[2]), c = atoi(argv[3]);
+    int heading = parseHeading(argv[4]);
+    int cellCost = argc == 7 ? atoi(argv[5]) : DEFAULT_CELL_COST;
+    int turnCost = argc == 7 ? atoi(argv[6]) : DEFAULT_TURN_COST;
+    if (!validCell(s, r, c, out))
+        return;
+    if (heading < 0)
+    {
+        fprintf(out, "ERR heading must be N, E, S or W\n");
+        return;
+    }
+    if (cellCost < 0 || turnCost < 0)
+    {
+        fprintf(out, "ERR costs must not be negative\n");
+        return;
+    }
+
+    Field *f = acquireField(s, GOAL_TARGET, scratch->queue);
+    long long cost;
+    int length = searchRoute(s->maze, f->dist, r, c, heading, cellCost, turnCost, scratch, &cost);
+    releaseField(s, f);
+    if (length < 0)
+    {
+        fprintf(out, "ERR unreachable\n");
+        return;
+    }
+
+    // turn into commands, merging straight cells into one Fn
+    const char *steps = scratch->steps;
+    char *commands = malloc(length * 8 + 2);
+    int used = 0;
+    int run = 0;
+    for (int i = 0; i < length; i++)
+    {
+        int turn = (steps[i] - heading + 4) % 4;
+        if (turn != 0 && run > 0)
+        {
+            used += sprintf(commands + used, " F%d", run);
+            run = 0;
+        }
+        if (turn == 1)
+            used += sprintf(commands + used, " R");
+        else if (turn == 3)
+            used += sprintf(commands + used, " L");
+        else if (turn == 2)
+            used += sprintf(commands + used, " U");
+        heading = steps[i];
+        run++;
+    }
+    if (run > 0)
+        used += sprintf(commands + used, " F%d", run);
+    commands[used] = '\0';
+    fprintf(out, "OK %lld%s\n", cost, commands);
+    free(commands);
+}
+
+static void answerMazes(FILE *out)
+{
+    fprintf(out, "OK %d", servedCount);
+    for (int i = 0; i < servedCount; i++)
+        fprintf(out, " %d:%dx%d:%s", i, served[i].maze->width, served[i].maze->height, served[i].name);
+    fputc('\n', out);
+}
+
+static void answerStats(FILE *out)
+{
+    fprintf(out, "OK");
+    for (int i = 0; i < servedCount; i++)
+    {
+        Served *s = &served[i];
+        pthread_mutex_lock(&s->lock);
+        int cached = 0;
+        for (int k = 0; k < fieldCapacity; k++)
+            cached += s->fields[k].dist != NULL;
+        fprintf(out, " %d:%lu:%lu:%d", i, s->hits, s->misses, cached);
+        pthread_mutex_unlock(&s->lock);
+    }
+    fputc('\n', out);
+}
+
+#define MAX_ARGS 8
+
+static void answer(char *line, Scratch *scratch, FILE *out)
+{
+    char *argv[MAX_ARGS];
+    int argc = 0;
+    char *save; // workers answer concurrently: strtok() would share its position
+    for (char *word = strtok_r(line, " \t", &save); word && argc < MAX_ARGS; word = strtok_r(NULL, " \t", &save))
+        argv[argc++] = word;
+
+    if (argc == 0)
+        fprintf(out, "ERR empty query\n");
+    else if (strcmp(argv[0], "MAZES") == 0)
+        answerMazes(out);
+    else if (strcmp(argv[0], "STATS") == 0)
+        answerStats(out);
+    else if (argc < 2)
+        fprintf(out, "ERR unknown query %s\n", argv[0]);
+    else
+    {
+        Served *s = parseMaze(argv[1], out);
+        if (!s)
+            return;
+        if (strcmp(argv[0], "FIELD") == 0)
+            answerField(s, argc, argv, scratch, out);
+        else if (strcmp(argv[0], "DIST") == 0)
+            answerRoute(s, argc, argv, 0, scratch, out);
+        else if (strcmp(argv[0], "ROUTE") == 0)
+            answerRoute(s, argc, argv, 1, scratch, out);
+        else if (strcmp(argv[0], "FAST") == 0)
+            answerFast(s, argc, argv, scratch, out);
+        else
+            fprintf(out, "ERR unknown query %s\n", argv[0]);
+    }
+}
+
+// ===== Server =====
+
+// Answer one batch into conn->reply. Runs on a worker thread.
+static void answerBatch(Connection *conn, Scratch *scratch)
+{
+    FILE *out = open_memstream(&conn->reply, &conn->replyLength);
+    for (char *line = conn->batch; *line;)
+    {
+        char *end = strchr(line, '\n');
+        if (end)
+            *end = '\0';
+        size_t length = strlen(line);
+        if (length > 0 && line[length - 1] == '\r')
+            line[--length] = '\0';
+        if (length > 0)
+            answer(line, scratch, out);
+        if (!end)
+            break;
+        line = end + 1;
+    }
+    if (conn->batchClosed)
+        fputc('\n', out); // end of batch
+    fclose(out);
+    free(conn->batch);
+    conn->batch = NULL;
+    conn->replySent = 0;
+}
+
+static void *runWorker(void *arg)
+{
+    (void)arg;
+    int states = maxCells * 4;
+    Scratch scratch;
+    scratch.queue = malloc(sizeof(int) * maxCells);
+    scratch.cost = malloc(sizeof(long long) * states);
+    scratch.parent = malloc(sizeof(int) * states);
+    scratch.stamp = calloc(states, sizeof(unsigned int));
+    scratch.generation = 0;
+    // a state goes on the heap only when it gets cheaper, at most once per
+    // way in (forward, two turns) plus the start headings
+    scratch.heapKey = malloc(sizeof(long long) * (states * 3 + 4));
+    scratch.heapState = malloc(sizeof(int) * (states * 3 + 4));
+    scratch.steps = malloc(states);
+
+    for (;;)
+    {
+        pthread_mutex_lock(&queueLock);
+        while (!queueHead)
+            pthread_cond_wait(&queueReady, &queueLock);
+        Connection *conn = queueHead;
+        queueHead = conn->next;
+        if (!queueHead)
+            queueTail = NULL;
+        pthread_mutex_unlock(&queueLock);
+
+        answerBatch(conn, &scratch);
+
+        pthread_mutex_lock(&queueLock);
+        conn->next = doneList;
+        doneList = conn;
+        pthread_mutex_unlock(&queueLock);
+        char wake = 1;
+        if (write(wakeFds[1], &wake, 1) < 0 && errno != EAGAIN)
+            perror("routed: wake");
+    }
+    return NULL;
+}
+
+// Hand the first complete batch in conn->input to the workers. At EOF the
+// rest of the input counts as a last, unterminated batch. Returns 1 if a
+// batch went out.
+static int dispatchBatch(Connection *conn)
+{
+    if (conn->busy || conn->replySent < conn->replyLength || conn->inputLength == 0)
+        return 0;
+
+    // a batch ends at an empty line (with or without \r); complete lines
+    // before inputScanned were checked on an earlier call
+    size_t length = 0;
+    int closed = 0;
+    size_t lineStart = conn->inputScanned;
+    for (size_t i = lineStart; i < conn->inputLength && !closed; i++)
+    {
+        if (conn->input[i] != '\n')
+            continue;
+        if (i == lineStart || (i == lineStart + 1 && conn->input[lineStart] == '\r'))
+        {
+            closed = 1;
+            length = i + 1;
+        }
+        lineStart = i + 1;
+    }
+    if (!closed)
+    {
+        conn->inputScanned = lineStart;
+        if (!conn->eof)
+            return 0;
+        length = conn->inputLength;
+    }
+
+    conn->batch = malloc(length + 1);
+    memcpy(conn->batch, conn->input, length);
+    conn->batch[length] = '\0';
+    conn->batchClosed = closed;
+    memmove(conn->input, conn->input + length, conn->inputLength - length);
+    conn->inputLength -= length;
+    conn->inputScanned = 0;
+
+    free(conn->reply);
+    conn->reply = NULL;
+    conn->replyLength = 0;
+    conn->busy = 1;
+    conn->next = NULL;
+    pthread_mutex_lock(&queueLock);
+    if (queueTail)
+        queueTail->next = conn;
+    else
+        queueHead = conn;
+    queueTail = conn;
+    pthread_cond_signal(&queueReady);
+    pthread_mutex_unlock(&queueLock);
+    return 1;
+}
+
+// Read what the client sent. Returns 0 when the connection is broken.
+static int readInput(Connection *conn)
+{
+    for (;;)
+    {
+        if (conn->inputLength == conn->inputSize)
+        {
+            if (conn->inputSize >= MAX_BATCH_BYTES)
+                return 1; // full: read again once a batch has gone to a worker
+            conn->inputSize = conn->inputSize ? conn->inputSize * 2 : 4096;
+            conn->input = realloc(conn->input, conn->inputSize);
+        }
+        ssize_t n = read(conn->fd, conn->input + conn->inputLength, conn->inputSize - conn->inputLength);
+        if (n > 0)
+        {
+            conn->inputLength += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 1;
+        conn->eof = 1;
+        return n == 0;
+    }
+}
+
+// Send what is left of the reply. Returns 0 when the connection is broken.
+static int writeReply(Connection *conn)
+{
+    while (conn->replySent < conn->replyLength)
+    {
+        ssize_t n = write(conn->fd, conn->reply + conn->replySent, conn->replyLength - conn->replySent);
+        if (n > 0)
+            conn->replySent += n;
+        else if (n < 0 && errno == EINTR)
+            continue;
+        else
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    return 1;
+}
+
+static void closeConnection(Connection *conn)
+{
+    close(conn->fd);
+    free(conn->input);
+    free(conn->reply);
+    free(conn);
+}
+
+static int listenOn(const char *path)
+{
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    // a socket left behind by a daemon that died is removed; a live one is
+    // another daemon's, and a file that is not a socket is not ours either
+    struct stat info;
+    if (lstat(path, &info) == 0)
+    {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        int live = probe >= 0 && connect(probe, (struct sockaddr *)&address, sizeof(address)) == 0;
+        if (probe >= 0)
+            close(probe);
+        if (live)
+        {
+            fprintf(stderr, "routed: another daemon is serving %s\n", path);
+            return -1;
+        }
+        if (!S_ISSOCK(info.st_mode))
+        {
+            fprintf(stderr, "routed: %s exists and is not a socket\n", path);
+            return -1;
+        }
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, PENDING_CLIENTS) != 0)
+    {
+        perror(path);
+        return -1;
+    }
+    return fd;
+}
+
+static int runServer(const char *path, int threads, char **specs, int count)
+{
+    served = calloc(count, sizeof(Served));
+    servedCount = count;
+    maxCells = 0;
+    for (int i = 0; i < count; i++)
+    {
+        Served *s = &served[i];
+        s->name = specs[i];
+        s->maze = openMazeSpec(specs[i]);
+        if (!s->maze)
+        {
+            fprintf(stderr, "cannot load maze %s\n", specs[i]);
+            return 1;
+        }
+        s->goalCount = centerGoals(s->maze->width, s->maze->height, s->goals);
+        s->fields = calloc(fieldCapacity, sizeof(Field));
+        pthread_mutex_init(&s->lock, NULL);
+        if (s->maze->width * s->maze->height > maxCells)
+            maxCells = s->maze->width * s->maze->height;
+    }
+
+    int listener = listenOn(path);
+    if (listener < 0 || pipe(wakeFds) != 0)
+        return 1;
+    signal(SIGPIPE, SIG_IGN); // a client that hangs up only ends its own connection
+    fcntl(listener, F_SETFL, O_NONBLOCK);
+    fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_t thread;
+        pthread_create(&thread, NULL, runWorker, NULL);
+        pthread_detach(thread);
+    }
+    fprintf(stderr, "routed: %d maze%s on %s, %d threads\n", count, count == 1 ? "" : "s", path, threads);
+
+    // Event loop: every connection lives here; workers see only batches.
+    Connection **conns = NULL;
+    int connCount = 0;
+    int connSize = 0;
+    struct pollfd *polls = NULL;
+    for (;;)
+    {
+        if (connSize < connCount + 2)
+        {
+            connSize = (connCount + 2) * 2;
+            conns = realloc(conns, sizeof(Connection *) * connSize);
+            polls = realloc(polls, sizeof(struct pollfd) * connSize);
+        }
+        polls[0] = (struct pollfd){listener, POLLIN, 0};
+        polls[1] = (struct pollfd){wakeFds[0], POLLIN, 0};
+        for (int i = 0; i < connCount; i++)
+        {
+            Connection *conn = conns[i];
+            short events = 0;
+            if (!conn->eof && conn->inputLength < MAX_BATCH_BYTES)
+                events |= POLLIN;
+            if (!conn->busy && conn->replySent < conn->replyLength)
+                events |= POLLOUT;
+            // nothing to wait for (busy, or done reading): a negative fd is skipped
+            polls[i + 2] = (struct pollfd){events ? conn->fd : -1, events, 0};
+        }
+        if (poll(polls, connCount + 2, 1000) < 0 && errno != EINTR)
+        {
+            perror("routed: poll");
+            return 1;
+        }
+        double time = benchSeconds();
+
+        // workers handing back answered batches
+        if (polls[1].revents & POLLIN)
+        {
+            char drain[64];
+            while (read(wakeFds[0], drain, sizeof(drain)) > 0)
+                ;
+        }
+        pthread_mutex_lock(&queueLock);
+        for (Connection *conn = doneList; conn; conn = conn->next)
+            conn->busy = 0;
+        doneList = NULL;
+        pthread_mutex_unlock(&queueLock);
+
+        int kept = 0;
+        for (int i = 0; i < connCount; i++)
+        {
+            Connection *conn = conns[i];
+            short revents = polls[i + 2].revents;
+            int alive = 1;
+            if (revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                alive = readInput(conn);
+                conn->lastActive = time;
+            }
+            if (alive && !conn->busy)
+            {
+                if (conn->replySent < conn->replyLength)
+                {
+                    alive = writeReply(conn);
+                    conn->lastActive = time;
+                }
+                if (alive && dispatchBatch(conn))
+                    conn->lastActive = time;
+                if (!conn->busy && conn->replySent == conn->replyLength)
+                {
+                    if (conn->eof && conn->inputLength == 0)
+                        alive = 0; // everything answered and sent
+                    else if (conn->inputLength >= MAX_BATCH_BYTES)
+                        alive = 0; // a batch that will never fit
+                    else if (time - conn->lastActive > idleSeconds)
+                        alive = 0;
+                }
+            }
+            if (alive || conn->busy)
+                conns[kept++] = conn;
+            else
+                closeConnection(conn);
+        }
+        connCount = kept;
+
+        if (polls[0].revents & POLLIN)
+        {
+            int fd;
+            while ((fd = accept(listener, NULL, NULL)) >= 0)
+            {
+                if (connSize < connCount + 3)
+                {
+                    connSize = (connCount + 3) * 2;
+                    conns = realloc(conns, sizeof(Connection *) * connSize);
+                    polls = realloc(polls, sizeof(struct pollfd) * connSize);
+                }
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+                Connection *conn = calloc(1, sizeof(Connection));
+                conn->fd = fd;
+                conn->lastActive = time;
+                conns[connCount++] = conn;
+            }
+        }
+    }
+}
+
+// ===== Clients =====
+
+static int connectTo(const char *path)
+{
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        perror(path);
+        return -1;
+    }
+    return fd;
+}
+
+static void *copyReplies(void *arg)
+{
+    FILE *in = fdopen(*(int *)arg, "r");
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+        fwrite(buffer, 1, n, stdout);
+    fflush(stdout);
+    return NULL;
+}
+
+// stdin goes out while a second thread prints the replies, so a large batch
+// cannot fill both socket buffers and stall
+static int runClient(const char *path)
+{
+    int fd = connectTo(path);
+    if (fd < 0)
+        return 1;
+    int readFd = dup(fd);
+    pthread_t reader;
+    pthread_create(&reader, NULL, copyReplies, &readFd);
+
+    FILE *out = fdopen(fd, "w");
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t length;
+    int open = 0; // a batch without its closing blank line yet
+    while ((length = getline(&line, &size, stdin)) >= 0)
+    {
+        fputs(line, out);
+        open = !(length == 1 && line[0] == '\n');
+    }
+    if (open)
+        fputs("\n", out);
+    fflush(out);
+    shutdown(fd, SHUT_WR);
+    pthread_join(reader, NULL);
+    fclose(out);
+    free(line);
+    return 0;
+}
+
+typedef struct
+{
+    const char *path;
+    int batches;
+    unsigned int seed;
+    long queries;
+    int failed;
+} BenchClient;
+
+static int readReplies(FILE *in, int count)
+{
+    char *line = NULL;
+    size_t size = 0;
+    int ok = 1;
+    for (int i = 0; i <= count; i++) // the replies and the blank line after them
+    {
+        if (getline(&line, &size, in) < 0 || (i < count && strncmp(line, "OK", 2) != 0))
+            ok = 0;
+    }
+    free(line);
+    return ok;
+}
+
+static void *runBenchClient(void *arg)
+{
+    BenchClient *b = (BenchClient *)arg;
+    int fd = connectTo(b->path);
+    if (fd < 0)
+    {
+        b->failed = 1;
+        return NULL;
+    }
+    FILE *out = fdopen(fd, "w");
+    FILE *in = fdopen(dup(fd), "r");
+
+    // learn the maze sizes first
+    int mazes = 0;
+    int sizes[64][2];
+    fprintf(out, "MAZES\n\n");
+    fflush(out);
+    char *line = NULL;
+    size_t size = 0;
+    if (getline(&line, &size, in) > 0)
+    {
+        char *p = line + 2;
+        int consumed;
+        sscanf(p, "%d%n", &mazes, &consumed);
+        p += consumed;
+        for (int i = 0; i < mazes && i < 64; i++)
+        {
+            sscanf(p, " %*d:%dx%d:%*s%n", &sizes[i][0], &sizes[i][1], &consumed);
+            p += consumed;
+        }
+        getline(&line, &size, in);
+    }
+    free(line);
+    if (mazes > 64)
+        mazes = 64;
+
+    for (int n = 0; n < b->batches && mazes > 0 && !b->failed; n++)
+    {
+        for (int i = 0; i < BENCH_BATCH; i++)
+        {
+            int m = rand_r(&b->seed) % mazes;
+            int r = rand_r(&b->seed) % sizes[m][1];
+            int c = rand_r(&b->seed) % sizes[m][0];
+            // a third each: fast runs, routes to the goal and routes to one of
+            // BENCH_TARGETS cells per maze, so the field cache sees reuse
+            int k = rand_r(&b->seed) % BENCH_TARGETS;
+            if (i % 3 == 0)
+                fprintf(out, "FAST %d %d %d N\n", m, r, c);
+            else if (i % 3 == 1)
+                fprintf(out, "ROUTE %d %d %d\n", m, r, c);
+            else
+                fprintf(out, "ROUTE %d %d %d %d %d\n", m, r, c, k * 7919 % sizes[m][1], k * 104729 % sizes[m][0]);
+        }
+        fprintf(out, "\n");
+        fflush(out);
+        if (!readReplies(in, BENCH_BATCH))
+            b->failed = 1;
+        b->queries += BENCH_BATCH;
+    }
+
+    fclose(in);
+    fclose(out);
+    return NULL;
+}
+
+static int runBench(const char *path, int clients, int batches)
+{
+    BenchClient *bench = calloc(clients, sizeof(BenchClient));
+    pthread_t *threads = malloc(sizeof(pthread_t) * clients);
+
+    double start = benchSeconds();
+    for (int i = 0; i < clients; i++)
+    {
+        bench[i] = (BenchClient){path, batches, 12345u + i, 0, 0};
+        pthread_create(&threads[i], NULL, runBenchClient, &bench[i]);
+    }
+    long queries = 0;
+    int failed = 0;
+    for (int i = 0; i < clients; i++)
+    {
+        pthread_join(threads[i], NULL);
+        queries += bench[i].queries;
+        failed += bench[i].failed;
+    }
+    double elapsed = benchSeconds() - start;
+
+    printf("%d clients: %ld queries in %.3f s, %.0f queries/s, %.1f us per batch of %d%s\n",
+           clients, queries, elapsed, queries / elapsed,
+           elapsed * 1e6 * clients / (queries / BENCH_BATCH), BENCH_BATCH,
+           failed ? " (some replies were errors)" : "");
+
+    // the daemon's cache counters: maze:hits:misses:fields
+    int fd = connectTo(path);
+    if (fd >= 0)
+    {
+        FILE *out = fdopen(fd, "w");
+        FILE *in = fdopen(dup(fd), "r");
+        fprintf(out, "STATS\n\n");
+        fflush(out);
+        char reply[1024];
+        if (fgets(reply, sizeof(reply), in))
+            printf("cache %s", reply + 3);
+        fclose(in);
+        fclose(out);
+    }
+
+    free(threads);
+    free(bench);
+    return failed != 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = DEFAULT_SOCKET;
+    int threads = DEFAULT_THREADS;
+
+    if (argc > 1 && strcmp(argv[1], "-client") == 0)
+        return runClient(argc > 2 ? argv[2] : path);
+    if (argc > 1 && strcmp(argv[1], "-bench") == 0)
+        return runBench(argc > 2 ? argv[2] : path, argc > 3 ? atoi(argv[3]) : 4, argc > 4 ? atoi(argv[4]) : 1000);
+
+    int i = 1;
+    for (; i + 1 < argc && argv[i][0] == '-'; i += 2)
+    {
+        if (strcmp(argv[i], "-s") == 0)
+            path = argv[i + 1];
+        else if (strcmp(argv[i], "-t") == 0)
+            threads = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-c") == 0)
+            fieldCapacity = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-i") == 0)
+            idleSeconds = atoi(argv[i + 1]);
+        else
+            break;
+    }
+
+    if (i >= argc || threads < 1 || fieldCapacity < 1 || idleSeconds < 1)
+    {
+        fprintf(stderr, "usage: routed [-s SOCKET] [-t THREADS] [-c FIELDS] [-i SECONDS] MAZE...\n"
+                        "       routed -client [SOCKET]\n"
+                        "       routed -bench [SOCKET] [CLIENTS] [BATCHES]\n");
+        return 1;
+    }
+    return runServer(path, threads, argv + i, argc - i);
+}
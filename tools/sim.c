@@ -0,0 +1,386 @@
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "../API.h"
+#include "../mazegen.h"
+#include "../solver.h"
+#include "../transport.h"
+
+// Local stand-in for the mms simulator, speaking either the text protocol or
+// the binary transport.
+// Build: gcc -O2 -DUSE_BINARY_TRANSPORT tools/sim.c API.c mazegen.c transport.c -o sim
+// and the solver with: gcc -O2 -DUSE_BINARY_TRANSPORT API.c solver.c main.c transport.c -o solver
+//
+//   sim [-t text|socket|shm] [-n MAX_STEPS] [-v] MAZE SOLVER
+//       MAZE is a .num file or ALGORITHM:SIZE:SEED to generate one.
+//       Runs SOLVER until the mouse reaches the center goal.
+//   sim -latency [-t text|socket|shm] [-n CALLS]
+//       Times API_wallFront() round trips through API.c.
+
+#define MODE_COUNT 3
+static const char *modeNames[MODE_COUNT] = {"text", "socket", "shm"};
+
+typedef struct
+{
+    Maze *maze;
+    int row;
+    int col;
+    int heading;
+    long moves;
+    long turns;
+    long crashes;
+    long calls;
+} Mouse;
+
+static pid_t childPid = 0;
+static int finished = 0;
+
+static void onChildExit(int sig)
+{
+    (void)sig;
+    if (!finished)
+    {
+        static const char msg[] = "sim: solver exited before reaching the goal\n";
+        write(2, msg, sizeof(msg) - 1);
+        _exit(1);
+    }
+}
+
+static int parseMode(const char *name)
+{
+    for (int i = 0; i < MODE_COUNT; i++)
+    {
+        if (strcmp(name, modeNames[i]) == 0)
+            return i;
+    }
+    fprintf(stderr, "unknown transport: %s\n", name);
+    return -1;
+}
+
+static int atGoal(const Mouse *mouse)
+{
+    int gr = mouse->maze->height / 2;
+    int gc = mouse->maze->width / 2;
+    return (mouse->row == gr || mouse->row == gr - 1) && (mouse->col == gc || mouse->col == gc - 1);
+}
+
+// Apply one command to the mouse. Returns the reply value.
+static int execute(Mouse *mouse, int opcode)
+{
+    mouse->calls++;
+    switch (opcode)
+    {
+    case OP_MAZE_WIDTH:
+        return mouse->maze->width;
+    case OP_MAZE_HEIGHT:
+        return mouse->maze->height;
+    case OP_WALL_FRONT:
+        return mazeHasWall(mouse->maze, mouse->row, mouse->col, mouse->heading);
+    case OP_WALL_RIGHT:
+        return mazeHasWall(mouse->maze, mouse->row, mouse->col, (mouse->heading + 1) % 4);
+    case OP_WALL_LEFT:
+        return mazeHasWall(mouse->maze, mouse->row, mouse->col, (mouse->heading + 3) % 4);
+    case OP_MOVE_FORWARD:
+        if (mazeHasWall(mouse->maze, mouse->row, mouse->col, mouse->heading))
+        {
+            mouse->crashes++;
+            return 0;
+        }
+        mouse->row += (mouse->heading == SOUTH) - (mouse->heading == NORTH);
+        mouse->col += (mouse->heading == EAST) - (mouse->heading == WEST);
+        mouse->moves++;
+        return 1;
+    case OP_TURN_RIGHT:
+        mouse->heading = (mouse->heading + 1) % 4;
+        mouse->turns++;
+        return 1;
+    case OP_TURN_LEFT:
+        mouse->heading = (mouse->heading + 3) % 4;
+        mouse->turns++;
+        return 1;
+    case OP_WAS_RESET:
+        return 0;
+    default:
+        return 1; // acks and display commands
+    }
+}
+
+static const struct
+{
+    const char *name;
+    int opcode;
+} textCommands[] = {
+    {"mazeWidth", OP_MAZE_WIDTH}, {"mazeHeight", OP_MAZE_HEIGHT}, {"wallFront", OP_WALL_FRONT},
+    {"wallRight", OP_WALL_RIGHT}, {"wallLeft", OP_WALL_LEFT}, {"moveForward", OP_MOVE_FORWARD},
+    {"turnRight", OP_TURN_RIGHT}, {"turnLeft", OP_TURN_LEFT}, {"setWall", OP_SET_WALL},
+    {"clearWall", OP_CLEAR_WALL}, {"setColor", OP_SET_COLOR}, {"clearColor", OP_CLEAR_COLOR},
+    {"clearAllColor", OP_CLEAR_ALL_COLOR}, {"setText", OP_SET_TEXT}, {"clearText", OP_CLEAR_TEXT},
+    {"clearAllText", OP_CLEAR_ALL_TEXT}, {"wasReset", OP_WAS_RESET}, {"ackReset", OP_ACK_RESET},
+};
+
+static int textOpcode(const char *line)
+{
+    size_t len = strcspn(line, " \n");
+    for (size_t i = 0; i < sizeof(textCommands) / sizeof(textCommands[0]); i++)
+    {
+        if (strlen(textCommands[i].name) == len && strncmp(line, textCommands[i].name, len) == 0)
+            return textCommands[i].opcode;
+    }
+    return 0;
+}
+
+static void textReply(FILE *out, int opcode, int value)
+{
+    if (opcode == OP_MAZE_WIDTH || opcode == OP_MAZE_HEIGHT)
+        fprintf(out, "%d\n", value);
+    else if (opcode == OP_WALL_FRONT || opcode == OP_WALL_RIGHT || opcode == OP_WALL_LEFT || opcode == OP_WAS_RESET)
+        fputs(value ? "true\n" : "false\n", out);
+    else
+        fputs(value ? "ack\n" : "crash\n", out);
+    fflush(out);
+}
+
+// Start the solver with its end of the channel. For text, toChild/fromChild
+// become its stdin/stdout.
+static pid_t spawn(char *const argv[], int mode, int childFd, int toChild, int fromChild, int verbose)
+{
+    pid_t pid = fork();
+    if (pid != 0)
+        return pid;
+
+    if (mode == TRANSPORT_TEXT)
+    {
+        dup2(toChild, 0);
+        dup2(fromChild, 1);
+    }
+    else
+    {
+        // keep the channel fd open across exec
+        fcntl(childFd, F_SETFD, 0);
+        char spec[32];
+        snprintf(spec, sizeof(spec), "%s:%d", modeNames[mode], childFd);
+        setenv("MAZE_TRANSPORT", spec, 1);
+    }
+    if (!verbose)
+    {
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, 2);
+    }
+    execvp(argv[0], argv);
+    perror("exec");
+    _exit(127);
+}
+
+static int runSolver(Maze *maze, int mode, long maxSteps, int verbose, char *const solverArgv[])
+{
+    Mouse mouse = {maze, maze->height - 1, 0, NORTH, 0, 0, 0, 0};
+    Channel channel;
+    int childFd = -1;
+    int toChild[2], fromChild[2];
+    FILE *in = NULL, *out = NULL;
+
+    if (mode == TRANSPORT_TEXT)
+    {
+        if (pipe(toChild) != 0 || pipe(fromChild) != 0)
+            return 1;
+    }
+    else if (transportCreate(&channel, mode, &childFd) != 0)
+    {
+        perror("transport");
+        return 1;
+    }
+
+    signal(SIGCHLD, onChildExit);
+    double start = benchSeconds();
+    childPid = spawn(solverArgv, mode, childFd, toChild[0], fromChild[1], verbose);
+
+    if (mode == TRANSPORT_TEXT)
+    {
+        close(toChild[0]);
+        close(fromChild[1]);
+        out = fdopen(toChild[1], "w");
+        in = fdopen(fromChild[0], "r");
+    }
+    else if (mode == TRANSPORT_SOCKET)
+    {
+        close(childFd);
+    }
+
+    char line[256];
+    long steps = 0;
+    while (!atGoal(&mouse) && mouse.moves + mouse.turns < maxSteps)
+    {
+        int opcode;
+        if (mode == TRANSPORT_TEXT)
+        {
+            if (!fgets(line, sizeof(line), in))
+                break;
+            opcode = textOpcode(line);
+        }
+        else
+        {
+            Frame request;
+            if (transportReceive(&channel, &request) != 0)
+                break;
+            opcode = request.opcode;
+        }
+
+        int value = execute(&mouse, opcode);
+        if (!opcodeHasReply(opcode))
+            continue;
+        steps++;
+        if (mode == TRANSPORT_TEXT)
+        {
+            textReply(out, opcode, value);
+        }
+        else
+        {
+            Frame reply = {0};
+            reply.opcode = opcode;
+            reply.value = value;
+            transportReply(&channel, &reply);
+        }
+    }
+    double elapsed = benchSeconds() - start;
+
+    finished = 1;
+    kill(childPid, SIGKILL);
+    waitpid(childPid, NULL, 0);
+
+    printf("%s %dx%d: %s after %ld moves, %ld turns, %ld crashes; %ld commands (%ld answered) in %.3f s\n",
+           modeNames[mode], maze->width, maze->height, atGoal(&mouse) ? "goal" : "gave up",
+           mouse.moves, mouse.turns, mouse.crashes, mouse.calls, steps, elapsed);
+    return atGoal(&mouse) ? 0 : 2;
+}
+
+// Child side of -latency: time API_wallFront() through API.c.
+static void latencyClient(long calls)
+{
+    double start = benchSeconds();
+    int sum = 0;
+    for (long i = 0; i < calls; i++)
+        sum += API_wallFront();
+    double elapsed = benchSeconds() - start;
+    fprintf(stderr, "%.1f ns per API_wallFront() call (%ld calls, %d walls)\n", elapsed * 1e9 / calls, calls, sum);
+}
+
+static int runLatency(int mode, long calls)
+{
+    Maze *maze = createMaze(2, 2);
+    Mouse mouse = {maze, 1, 0, NORTH, 0, 0, 0, 0};
+    Channel channel;
+    int childFd = -1;
+    int toChild[2], fromChild[2];
+
+    if (mode == TRANSPORT_TEXT)
+    {
+        if (pipe(toChild) != 0 || pipe(fromChild) != 0)
+            return 1;
+    }
+    else if (transportCreate(&channel, mode, &childFd) != 0)
+    {
+        perror("transport");
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        if (mode == TRANSPORT_TEXT)
+        {
+            dup2(toChild[0], 0);
+            dup2(fromChild[1], 1);
+        }
+        else
+        {
+            char spec[32];
+            snprintf(spec, sizeof(spec), "%s:%d", modeNames[mode], childFd);
+            setenv("MAZE_TRANSPORT", spec, 1);
+        }
+        latencyClient(calls);
+        _exit(0);
+    }
+
+    printf("%s: ", modeNames[mode]);
+    fflush(stdout);
+    FILE *in = NULL, *out = NULL;
+    if (mode == TRANSPORT_TEXT)
+    {
+        out = fdopen(toChild[1], "w");
+        in = fdopen(fromChild[0], "r");
+    }
+
+    char line[256];
+    for (long i = 0; i < calls; i++)
+    {
+        if (mode == TRANSPORT_TEXT)
+        {
+            if (!fgets(line, sizeof(line), in))
+                break;
+            textReply(out, OP_WALL_FRONT, execute(&mouse, textOpcode(line)));
+        }
+        else
+        {
+            Frame request, reply = {0};
+            if (transportReceive(&channel, &request) != 0)
+                break;
+            reply.value = execute(&mouse, request.opcode);
+            transportReply(&channel, &reply);
+        }
+    }
+    waitpid(pid, NULL, 0);
+    freeMaze(maze);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int mode = TRANSPORT_TEXT;
+    long limit = -1;
+    int verbose = 0;
+    int latency = 0;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            mode = parseMode(argv[++i]);
+            if (mode < 0)
+                return 1;
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            limit = atol(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0)
+            verbose = 1;
+        else if (strcmp(argv[i], "-latency") == 0)
+            latency = 1;
+        else
+            break;
+    }
+
+    if (latency)
+        return runLatency(mode, limit > 0 ? limit : 100000);
+
+    if (argc - i < 2)
+    {
+        fprintf(stderr, "usage: sim [-t text|socket|shm] [-n MAX_STEPS] [-v] MAZE SOLVER [ARGS]\n"
+                        "       sim -latency [-t text|socket|shm] [-n CALLS]\n");
+        return 1;
+    }
+
+    Maze *maze = openMazeSpec(argv[i]);
+    if (!maze)
+    {
+        fprintf(stderr, "cannot load maze %s\n", argv[i]);
+        return 1;
+    }
+    int result = runSolver(maze, mode, limit > 0 ? limit : 100000, verbose, &argv[i + 1]);
+    freeMaze(maze);
+    return result;
+}
@@ -0,0 +1,299 @@
+#define _GNU_SOURCE
+#include "transport.h"
+#include <errno.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define RING_SLOTS 64 // power of two
+// polls before a reader or a blocked writer goes to sleep on the futex;
+// spinning only pays off when the other side runs on another CPU
+#define SPIN_LIMIT 4000
+// how long a blocked side sleeps before checking that its peer still exists
+#define PEER_CHECK_NS 100000000
+
+typedef struct
+{
+    _Atomic unsigned int head;      // next slot to write, only the producer moves it
+    _Atomic int consumerWaiting;    // consumer sleeps on head
+    char pad0[56];                  // keep producer and consumer fields on separate cache lines
+    _Atomic unsigned int tail;      // next slot to read, only the consumer moves it
+    _Atomic int producerWaiting;    // producer sleeps on tail (ring full)
+    char pad1[56];
+    Frame slots[RING_SLOTS];
+} Ring;
+
+struct ShmRings
+{
+    Ring requests; // solver -> simulator
+    Ring replies;  // simulator -> solver
+    _Atomic int serverPid; // set by transportCreate
+    _Atomic int clientPid; // set by transportOpen, 0 until the solver attaches
+};
+
+_Static_assert(sizeof(Frame) == 16, "Frame must stay 16 bytes");
+
+// ===== futex helpers =====
+
+static void futexWait(_Atomic unsigned int *addr, unsigned int expected)
+{
+    // shared futex (no FUTEX_PRIVATE_FLAG): the two sides are different processes;
+    // the timeout lets the caller notice a peer that died while we slept
+    struct timespec timeout = {0, PEER_CHECK_NS};
+    syscall(SYS_futex, (unsigned int *)addr, FUTEX_WAIT, expected, &timeout, NULL, 0);
+}
+
+static void futexWake(_Atomic unsigned int *addr)
+{
+    syscall(SYS_futex, (unsigned int *)addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static int spinLimit()
+{
+    static int limit = -1;
+    if (limit < 0)
+        limit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN_LIMIT : 0;
+    return limit;
+}
+
+static void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// A peer that has not attached yet (pid 0) counts as alive.
+static int peerGone(_Atomic int *peerPid)
+{
+    int pid = atomic_load(peerPid);
+    return pid > 0 && kill(pid, 0) != 0 && errno == ESRCH;
+}
+
+// ===== shared memory rings =====
+
+// Both return -1 when the peer process is gone while waiting.
+static int ringPush(Ring *ring, const Frame *frame, _Atomic int *peerPid)
+{
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    // wait for a free slot
+    int spins = 0;
+    unsigned int tail;
+    while (head - (tail = atomic_load_explicit(&ring->tail, memory_order_acquire)) == RING_SLOTS)
+    {
+        if (++spins < spinLimit())
+        {
+            cpuRelax();
+            continue;
+        }
+        atomic_store(&ring->producerWaiting, 1);
+        if (head - atomic_load(&ring->tail) == RING_SLOTS)
+            futexWait(&ring->tail, tail);
+        atomic_store(&ring->producerWaiting, 0);
+        if (peerGone(peerPid))
+            return -1;
+    }
+
+    ring->slots[head % RING_SLOTS] = *frame;
+    atomic_store(&ring->head, head + 1); // seq_cst: ordered before the waiting check
+    if (atomic_load(&ring->consumerWaiting))
+        futexWake(&ring->head);
+    return 0;
+}
+
+static int ringPop(Ring *ring, Frame *frame, _Atomic int *peerPid)
+{
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    int spins = 0;
+    unsigned int head;
+    while ((head = atomic_load_explicit(&ring->head, memory_order_acquire)) == tail)
+    {
+        if (++spins < spinLimit())
+        {
+            cpuRelax();
+            continue;
+        }
+        atomic_store(&ring->consumerWaiting, 1);
+        if (atomic_load(&ring->head) == tail)
+            futexWait(&ring->head, tail);
+        atomic_store(&ring->consumerWaiting, 0);
+        if (peerGone(peerPid))
+            return -1;
+    }
+
+    *frame = ring->slots[tail % RING_SLOTS];
+    atomic_store(&ring->tail, tail + 1);
+    if (atomic_load(&ring->producerWaiting))
+        futexWake(&ring->tail);
+    return 0;
+}
+
+// ===== sockets =====
+
+static int writeFull(int fd, const void *data, size_t size)
+{
+    const char *p = data;
+    while (size > 0)
+    {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+static int readFull(int fd, void *data, size_t size)
+{
+    char *p = data;
+    while (size > 0)
+    {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// ===== channels =====
+
+static ShmRings *mapRings(int fd)
+{
+    void *p = mmap(NULL, sizeof(ShmRings), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return p == MAP_FAILED ? NULL : (ShmRings *)p;
+}
+
+int transportCreate(Channel *server, int mode, int *childFd)
+{
+    memset(server, 0, sizeof(*server));
+    server->mode = mode;
+
+    if (mode == TRANSPORT_SOCKET)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+            return -1;
+        server->fd = fds[0];
+        *childFd = fds[1];
+        return 0;
+    }
+
+    if (mode == TRANSPORT_SHM)
+    {
+        int fd = memfd_create("maze-transport", MFD_CLOEXEC);
+        if (fd < 0)
+            return -1;
+        if (ftruncate(fd, sizeof(ShmRings)) != 0 || !(server->shm = mapRings(fd)))
+        {
+            close(fd);
+            return -1;
+        }
+        // a fresh memfd is zero filled: both rings start empty
+        atomic_store(&server->shm->serverPid, getpid());
+        server->fd = fd;
+        *childFd = fd;
+        return 0;
+    }
+
+    return -1;
+}
+
+int transportOpen(Channel *client, const char *spec)
+{
+    memset(client, 0, sizeof(*client));
+    if (strncmp(spec, "socket:", 7) == 0)
+    {
+        client->mode = TRANSPORT_SOCKET;
+        client->fd = atoi(spec + 7);
+        return 0;
+    }
+    if (strncmp(spec, "shm:", 4) == 0)
+    {
+        client->mode = TRANSPORT_SHM;
+        client->fd = atoi(spec + 4);
+        client->shm = mapRings(client->fd);
+        if (!client->shm)
+            return -1;
+        atomic_store(&client->shm->clientPid, getpid());
+        return 0;
+    }
+    return -1;
+}
+
+void transportClose(Channel *channel)
+{
+    if (channel->shm)
+        munmap(channel->shm, sizeof(ShmRings));
+    if (channel->fd > 0)
+        close(channel->fd);
+    channel->shm = NULL;
+    channel->fd = -1;
+}
+
+int transportCall(Channel *client, const Frame *request, Frame *reply)
+{
+    if (client->mode == TRANSPORT_SHM)
+    {
+        ShmRings *shm = client->shm;
+        if (ringPush(&shm->requests, request, &shm->serverPid) != 0)
+            return -1;
+        if (reply && ringPop(&shm->replies, reply, &shm->serverPid) != 0)
+            return -1;
+        return 0;
+    }
+
+    if (writeFull(client->fd, request, sizeof(Frame)) != 0)
+        return -1;
+    if (reply && readFull(client->fd, reply, sizeof(Frame)) != 0)
+        return -1;
+    return 0;
+}
+
+int transportReceive(Channel *server, Frame *request)
+{
+    if (server->mode == TRANSPORT_SHM)
+        return ringPop(&server->shm->requests, request, &server->shm->clientPid);
+    return readFull(server->fd, request, sizeof(Frame));
+}
+
+int transportReply(Channel *server, const Frame *reply)
+{
+    if (server->mode == TRANSPORT_SHM)
+        return ringPush(&server->shm->replies, reply, &server->shm->clientPid);
+    return writeFull(server->fd, reply, sizeof(Frame));
+}
+
+int opcodeHasReply(int opcode)
+{
+    switch (opcode)
+    {
+    case OP_MAZE_WIDTH:
+    case OP_MAZE_HEIGHT:
+    case OP_WALL_FRONT:
+    case OP_WALL_RIGHT:
+    case OP_WALL_LEFT:
+    case OP_MOVE_FORWARD:
+    case OP_TURN_RIGHT:
+    case OP_TURN_LEFT:
+    case OP_WAS_RESET:
+    case OP_ACK_RESET:
+        return 1;
+    default:
+        return 0;
+    }
+}
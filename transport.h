@@ -0,0 +1,87 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+// Binary framed transport between the solver and a simulator.
+//
+// Every request and every reply is one fixed 16-byte Frame. Commands that
+// return something in the text protocol (getInteger/getBoolean/getAck in
+// API.c) wait for a reply frame, display commands are fire-and-forget.
+//
+// Two carriers:
+//   socket: a Unix socketpair, one frame per write()
+//   shm:    a shared memory region with two single-producer/single-consumer
+//           rings; the reader spins briefly, then sleeps on a futex
+//
+// The solver picks the transport from the MAZE_TRANSPORT environment variable
+// ("socket:<fd>" or "shm:<fd>", set up by the simulator). Without it API.c
+// keeps using the text protocol on stdin/stdout.
+
+#define TRANSPORT_TEXT 0
+#define TRANSPORT_SOCKET 1
+#define TRANSPORT_SHM 2
+
+enum Opcode
+{
+    OP_MAZE_WIDTH = 1,
+    OP_MAZE_HEIGHT,
+    OP_WALL_FRONT,
+    OP_WALL_RIGHT,
+    OP_WALL_LEFT,
+    OP_MOVE_FORWARD,
+    OP_TURN_RIGHT,
+    OP_TURN_LEFT,
+    OP_SET_WALL,
+    OP_CLEAR_WALL,
+    OP_SET_COLOR,
+    OP_CLEAR_COLOR,
+    OP_CLEAR_ALL_COLOR,
+    OP_SET_TEXT,
+    OP_CLEAR_TEXT,
+    OP_CLEAR_ALL_TEXT,
+    OP_WAS_RESET,
+    OP_ACK_RESET
+};
+
+#define FRAME_TEXT_SIZE 6
+
+typedef struct Frame
+{
+    int value; // reply value (integer, boolean or ack)
+    short x;
+    short y;
+    unsigned char opcode;
+    char arg;                   // wall direction or color
+    char text[FRAME_TEXT_SIZE]; // setText payload, truncated, not NUL terminated when full
+} Frame;
+
+typedef struct ShmRings ShmRings;
+
+typedef struct Channel
+{
+    int mode;
+    int fd;
+    ShmRings *shm;
+} Channel;
+
+// Simulator side: create a channel and the fd the solver process inherits.
+// Returns 0 on success.
+int transportCreate(Channel *server, int mode, int *childFd);
+
+// Solver side: attach to a channel from a MAZE_TRANSPORT spec.
+int transportOpen(Channel *client, const char *spec);
+
+void transportClose(Channel *channel);
+
+// Send a request. With reply != NULL, block until the reply frame arrives.
+// All calls below return -1 once the other side is gone: the socket closed,
+// or on shm the peer process exited while we waited.
+int transportCall(Channel *client, const Frame *request, Frame *reply);
+
+// Simulator side: block for the next request, answer it.
+int transportReceive(Channel *server, Frame *request);
+int transportReply(Channel *server, const Frame *reply);
+
+// Whether the text protocol answers this opcode (and so the binary one does too).
+int opcodeHasReply(int opcode);
+
+#endif